@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+
+#include "daxpy.hpp"
+#include "sum.hpp"
+#include "vector.hpp"
+
+double separate_calls(size_t n, double a, double b, const double *x, const double *y, const double *z,
+                      const double *w, double *d, double *tmp) {
+    // d = a*x + b*y - z; s = dot(d, w) as a sequence of level-1 calls,
+    // each one a sweep over memory: d = -z, d += a*x, d += b*y,
+    // tmp = d .* w, s = sum(tmp)
+    for (size_t i = 0; i < n; i++) {
+        d[i] = -z[i];
+    }
+    daxpy(n, a, x, d);
+    daxpy(n, b, y, d);
+    for (size_t i = 0; i < n; i++) {
+        tmp[i] = d[i] * w[i];
+    }
+    return KahanBabushkaNeumaierSum(tmp, n);
+}
+
+template <typename F>
+double time_best(F f, int repeat) {
+    // best of repeat runs, in seconds
+    double best = INFINITY;
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+int main() {
+    // d = a*x + b*y - z; s = dot(d, w), three ways: separate level-1
+    // calls, two lazy expressions (one loop each) and one fused loop.
+    // Memory traffic per element, in doubles: 12, 6 and 5.
+    const double a = 3.0, b = -0.5;
+    const double TOLERANCE = 1e-12; // relative, on s
+    const size_t N[] = {1000, 100000, 10000000, 50000000};
+    const int REPEAT = 5;
+
+    for (const size_t n: N) {
+        std::cout << "----------------------------------------" << std::endl;
+        std::cout << "Testing with n = " << n << std::endl;
+
+        Vector<double> x(n), y(n), z(n), w(n), d(n), tmp(n);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = sin(0.001 * i);
+            y[i] = cos(0.002 * i);
+            z[i] = 0.1;
+            w[i] = 1.0 / (1.0 + i % 7);
+        }
+
+        double s_ref = 0.0, s_lazy = 0.0, s_fused = 0.0;
+        double t_ref = time_best([&] {
+            s_ref = separate_calls(n, a, b, x.data(), y.data(), z.data(), w.data(), d.data(), tmp.data());
+        }, REPEAT);
+        double t_lazy = time_best([&] {
+            d = a*x + b*y - z;
+            s_lazy = dot(d, w);
+        }, REPEAT);
+        double t_fused = time_best([&] {
+            s_fused = assign_and_dot(d, a*x + b*y - z, w);
+        }, REPEAT);
+
+        std::cout << "\t separate calls: " << t_ref << " seconds, " << 12e-9 * n * sizeof(double) / t_ref << " GB/s" << std::endl;
+        std::cout << "\t expressions: " << t_lazy << " seconds (" << t_ref / t_lazy << "x)" << std::endl;
+        std::cout << "\t fused: " << t_fused << " seconds (" << t_ref / t_fused << "x)" << std::endl;
+
+        if (fabs(s_lazy - s_ref) > TOLERANCE * fabs(s_ref) || fabs(s_fused - s_ref) > TOLERANCE * fabs(s_ref)) {
+            std::cerr << "[error] dot products differ: " << s_ref << " " << s_lazy << " " << s_fused << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "----------------------------------------" << std::endl;
+    return 0;
+}
@@ -3,35 +3,7 @@
 #include <iostream>
 #include <chrono>
 
-
-void daxpy(int n, double a, double *x, double *y) {
-    if (n <= 0 || a == 0.0) {
-        return;
-    }
-
-    for (int i = 0; i < n; i++) {
-        y[i] += a * x[i];
-    }
-}
-
-void daxpy_unrolled(int n, double a, double *x, double *y) {
-
-    if (n <= 0 || a == 0.0) {
-        return;
-    }
-
-    int m = n % 4;
-    for (int i = 0; i < m; i++) {
-        y[i] += a * x[i];
-    }
-
-    for (int i = m; i < n; i += 4) {
-        y[i] += a * x[i];
-        y[i + 1] += a * x[i + 1];
-        y[i + 2] += a * x[i + 2];
-        y[i + 3] += a * x[i + 3];
-    }
-}
+#include "daxpy.hpp"
 
 int main(int argc, char* argv[]) {
     
@@ -39,6 +11,8 @@ int main(int argc, char* argv[]) {
     const double a = 3.;
     const size_t ARRAY_SIZES[] = {10, 1000, 10000, 1000000, 100000000};
 
+    std::cout << "daxpy kernel: " << isa_name(daxpy_selected_isa()) << std::endl;
+
     // Test memory allocation on the stack and heap
     // for each array size and implementation of daxpy
     for (const size_t n: ARRAY_SIZES) {
@@ -1,11 +1,18 @@
+#include <algorithm>
 #include <cmath>
 #include <chrono>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
 
-void square_matmul(size_t n, double *a, double *b, double *c) {
-    // This function computes the matrix product C = A * B
-    // where A, B, and C are n x n matrices.
-    // Assumes the matrices are stored in row-major order.
+#include "gemm.hpp"
+#include "small_matmul.hpp"
+
+void square_matmul_naive(size_t n, double *a, double *b, double *c) {
+    // Textbook i-j-k triple loop, kept as a reference:
+    // the inner loop walks a column of B with stride n.
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
             c[i * n + j] = 0;
@@ -16,26 +23,160 @@ void square_matmul(size_t n, double *a, double *b, double *c) {
     }
 }
 
-bool allclose(double *C, double expected, size_t &n, double tolerance) {
-    // This function checks if all elements of C are close to the expected value
-    // within the specified tolerance.
-    // It returns true if all elements are close, false otherwise.
-    // It also updates n to the index of the first false check.
+void square_matmul(size_t n, double *a, double *b, double *c) {
+    // This function computes the matrix product C = A * B
+    // where A, B, and C are n x n matrices.
+    // Assumes the matrices are stored in row-major order.
+    // Uses the cache-blocked, packed dgemm of the shared kernels.
+    dgemm(n, n, n, 1.0, a, n, b, n, 0.0, c, n);
+}
+
+void square_matmul_parallel(size_t n, double *a, double *b, double *c) {
+    // Same as square_matmul, with C split in 2D tiles across
+    // the OpenMP threads (set their number with OMP_NUM_THREADS).
+    dgemm_parallel(n, n, n, 1.0, a, n, b, n, 0.0, c, n);
+}
+
+void square_matmul_strassen(size_t n, double *a, double *b, double *c) {
+    // Strassen-Winograd recursion down to STRASSEN_DEFAULT_CUTOFF,
+    // then the parallel blocked dgemm.
+    dgemm_strassen(n, a, n, b, n, c, n);
+}
 
-    for (int i = 0; i < n * n; i++) {
-        if (fabs(C[i] - expected) >= tolerance) {
-            n = i;
-            return false;
+double max_abs_diff(const double *C, const double *C_ref, size_t size, double &max_ref) {
+    // Largest |C - C_ref| over all elements, max_ref is set to
+    // the largest |C_ref| to turn it into a relative error.
+    double max_diff = 0.0;
+    max_ref = 0.0;
+    for (size_t i = 0; i < size; i++) {
+        max_diff = std::max(max_diff, fabs(C[i] - C_ref[i]));
+        max_ref = std::max(max_ref, fabs(C_ref[i]));
+    }
+    return max_diff;
+}
+
+void benchmark_small_matmul(size_t count, int repeat) {
+    // Multiply count pairs of 6x6 matrices (the size used in the fft task)
+    // repeat times with the generic loop, the unrolled matmul<6,6,6> and
+    // the batched interleaved version, and check they all agree.
+    // Keep count small enough for the batch to stay in cache, otherwise
+    // all three just measure memory bandwidth.
+    const int S = 6;
+    const size_t size = S * S;
+    double *A = new double[count * size];
+    double *B = new double[count * size];
+    // value-initialize the outputs, so page faults are not timed
+    double *C = new double[count * size]();
+    double *C_ref = new double[count * size]();
+    const size_t soa_size = batch_storage_size(count, S, S);
+    double *A_soa = new double[soa_size];
+    double *B_soa = new double[soa_size];
+    double *C_soa = new double[soa_size]();
+
+    for (size_t i = 0; i < count * size; i++) {
+        A[i] = sin(0.1 * i);
+        B[i] = cos(0.3 * i);
+    }
+    interleave_batch(count, S, S, A, A_soa);
+    interleave_batch(count, S, S, B, B_soa);
+
+    std::cout << "Multiplying " << count << " " << S << "x" << S << " matrices " << repeat << " times..." << std::endl;
+    const double flops = 2. * S * S * S * count * repeat;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        for (size_t l = 0; l < count; l++) {
+            square_matmul_naive(S, A + l * size, B + l * size, C_ref + l * size);
         }
     }
-    return true;
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    std::cout << "\t loop: " << elapsed.count() << " seconds, " << 1e-9 * flops / elapsed.count() << " GFLOP/s" << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        for (size_t l = 0; l < count; l++) {
+            matmul<S, S, S>(A + l * size, B + l * size, C + l * size);
+        }
+    }
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    std::cout << "\t unrolled: " << elapsed.count() << " seconds, " << 1e-9 * flops / elapsed.count() << " GFLOP/s" << std::endl;
+
+    double max_err = 0.0;
+    for (size_t i = 0; i < count * size; i++) {
+        max_err = std::max(max_err, fabs(C[i] - C_ref[i]));
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        matmul_batched<S, S, S>(count, A_soa, B_soa, C_soa);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    std::cout << "\t batched: " << elapsed.count() << " seconds, " << 1e-9 * flops / elapsed.count() << " GFLOP/s" << std::endl;
+
+    deinterleave_batch(count, S, S, C_soa, C);
+    for (size_t i = 0; i < count * size; i++) {
+        max_err = std::max(max_err, fabs(C[i] - C_ref[i]));
+    }
+    std::cout << "\t max error against the loop: " << max_err << std::endl;
+
+    delete[] A;
+    delete[] B;
+    delete[] C;
+    delete[] C_ref;
+    delete[] A_soa;
+    delete[] B_soa;
+    delete[] C_soa;
 }
 
+struct MatmulImpl {
+    const char *name;
+    void (*run)(size_t n, double *a, double *b, double *c);
+};
+
 int main(int argc, char* argv[]) {
-    const double TOLERANCE = 1e-9;
+    // Usage: 02matmulCpp [naive] [blocked] [parallel] [strassen]
+    // (default: blocked parallel strassen). The naive product is always
+    // computed up to NAIVE_MAX_N as the reference for the errors; asking
+    // for it explicitly times it, and uses it as reference, for all N.
+    const double TOLERANCE = 1e-12; // on the error relative to max|C|
+    const size_t NAIVE_MAX_N = 1000;
     const size_t N[] = {10, 100, 1000, 10000};
-    const double a = 3.;
-    const double b = 7.1;
+    const MatmulImpl IMPLS[] = {
+        {"blocked", square_matmul},
+        {"parallel", square_matmul_parallel},
+        {"strassen", square_matmul_strassen},
+    };
+
+    bool naive_selected = false;
+    std::vector<const MatmulImpl *> selected;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "naive") {
+            naive_selected = true;
+            continue;
+        }
+        auto it = std::find_if(std::begin(IMPLS), std::end(IMPLS), [&](const MatmulImpl &impl) { return arg == impl.name; });
+        if (it == std::end(IMPLS)) {
+            std::cerr << "[error] unknown method <" << arg << ">, use naive, blocked, parallel or strassen" << std::endl;
+            return 1;
+        }
+        selected.push_back(&*it);
+    }
+    if (argc < 2) {
+        for (const MatmulImpl &impl: IMPLS) {
+            selected.push_back(&impl);
+        }
+    }
+
+    benchmark_small_matmul(1024, 1000);
+
+    std::cout << "dgemm micro-kernel: " << isa_name(dgemm_selected_isa()) << std::endl;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
 
     for (const size_t n: N) {
         std::cout << "Testing for N = " << n << "..." << std::endl;
@@ -45,42 +186,56 @@ int main(int argc, char* argv[]) {
         double *A = new double[n * n];
         double *B = new double[n * n];
         double *C = new double[n * n];
-
-        if (A == nullptr || B == nullptr || C == nullptr) {
-            std::cerr << "[error] memory allocation failed" << std::endl;
-            return 1;
-        }
+        double *C_ref = nullptr;
 
         for (size_t i = 0; i < n * n; i++) {
-            A[i] = a;
-            B[i] = b;
+            A[i] = dist(gen);
+            B[i] = dist(gen);
         }
-        
-        // Measure the time taken for the matrix multiplication
-        auto start = std::chrono::high_resolution_clock::now();
-        square_matmul(n, A, B, C);
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        std::cout << "Time taken for matrix multiplication: " << elapsed.count() << " seconds" << std::endl;
-
-        std::cout << "Checking the result..." << std::endl;
-        size_t first_false = n;
-        double expected_value = a * b * n;
-        bool test = allclose(C, expected_value, first_false, TOLERANCE);
-        if (test) {
-            std::cout << "Passed" << std::endl;
+
+        if (naive_selected || n <= NAIVE_MAX_N) {
+            C_ref = new double[n * n];
+            auto start = std::chrono::high_resolution_clock::now();
+            square_matmul_naive(n, A, B, C_ref);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
+            if (naive_selected) {
+                std::cout << "Time taken for matrix multiplication (naive): " << elapsed.count() << " seconds" << std::endl;
+                std::cout << "Performance: " << 2e-9 * n * n * n / elapsed.count() << " GFLOP/s" << std::endl;
+            }
         } else {
-            std::cout << "Failed" << std::endl;
-            printf("C[%d] = %.15f but expected %.15f\n", first_false, C[first_false], expected_value);
-            delete[] A;
-            delete[] B;
-            delete[] C;
-            return 1;
+            std::cout << "No naive reference for this N, skipping the error checks" << std::endl;
+        }
+
+        for (const MatmulImpl *impl: selected) {
+            // Measure the time taken for the matrix multiplication
+            auto start = std::chrono::high_resolution_clock::now();
+            impl->run(n, A, B, C);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = end - start;
+            std::cout << "Time taken for matrix multiplication (" << impl->name << "): " << elapsed.count() << " seconds" << std::endl;
+            std::cout << "Performance: " << 2e-9 * n * n * n / elapsed.count() << " GFLOP/s" << std::endl;
+
+            if (C_ref == nullptr) {
+                continue;
+            }
+            double max_ref;
+            double max_err = max_abs_diff(C, C_ref, n * n, max_ref);
+            std::cout << "Max error against naive: " << max_err << " (relative " << max_err / max_ref << ")" << std::endl;
+            if (max_err > TOLERANCE * max_ref) {
+                std::cout << "Failed" << std::endl;
+                delete[] A;
+                delete[] B;
+                delete[] C;
+                delete[] C_ref;
+                return 1;
+            }
         }
 
         delete[] A;
         delete[] B;
         delete[] C;
+        delete[] C_ref;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -1,25 +1,31 @@
 #include <iostream>
 #include <cmath>
 #include <chrono>
-#include <vector>
+#include <algorithm>
+
+#include "matrix.hpp"
 using namespace std;
 
-vector<vector<double>> matmul(const vector<vector<double>>& A, const vector<vector<double>>& B){
-    int vecSize = A.size();
-    vector<vector<double>> C(vecSize,vector<double>(vecSize,0.0f));
+Matrix matmul(ConstMatrixView A, ConstMatrixView B){
+    int vecSize = A.rows();
+    Matrix C(vecSize, vecSize, 0.0);
 
     auto start = chrono::high_resolution_clock::now();
     cout << "Initiating computation...\n";
     for (int row = 0; row < vecSize; row++){
-        if (row % (vecSize/100) == 0){
+        if (row % max(vecSize/100, 1) == 0){
             cout << "|";
         }
-        for (int col = 0; col < vecSize; col++){
-            double sum = 0;
-            for(int k = 0; k < vecSize; k++){
-                sum += A[row][k]*B[k][col];
+        // row-k-col order: the inner loop streams contiguous
+        // rows of B and C instead of walking a column of B
+        double *Crow = C.row(row);
+        const double *Arow = A.row(row);
+        for(int k = 0; k < vecSize; k++){
+            const double a_rk = Arow[k];
+            const double *Brow = B.row(k);
+            for (int col = 0; col < vecSize; col++){
+                Crow[col] += a_rk*Brow[col];
             }
-            C[row][col] = sum;
         }
     }
     auto end = chrono::high_resolution_clock::now();
@@ -27,11 +33,12 @@ vector<vector<double>> matmul(const vector<vector<double>>& A, const vector<vect
     cout << "\nComputation concluded in " << duration.count() << " seconds.\n";
     return C;
 }
-bool allEqual(const vector<vector<double>> array, double val, double tol = 0){
-    int N = array.size();
+bool allEqual(ConstMatrixView array, double val, double tol = 0){
+    int N = array.rows();
     for (int it = 0;it<N; it++){
+        const double *row = array.row(it);
         for (int it2 = 0; it2<N;it2++){
-            if (abs(array[it][it2]-val)>tol){
+            if (abs(row[it2]-val)>tol){
                 return false;
             }
         }
@@ -47,10 +54,10 @@ int main(){
 
     for (int it = 0;it<3;it++){
         cout << "N = " << dims[it] << "\n";
-        vector<vector<double>> x(dims[it], vector<double>(dims[it],x_val));
-        vector<vector<double>> y(dims[it], vector<double>(dims[it],y_val));
-        vector<vector<double>> res = matmul(x,y);
-        if (!allEqual(res,exp_res*dims[it],1)){
+        Matrix x(dims[it], dims[it], x_val);
+        Matrix y(dims[it], dims[it], y_val);
+        Matrix res = matmul(x.view(),y.view());
+        if (!allEqual(res.view(),exp_res*dims[it],1)){
             cout << "The operation has not been properly computed.\n";
             break;
         }
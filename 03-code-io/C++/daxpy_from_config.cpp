@@ -1,27 +1,134 @@
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <memory>
 #include <iostream>
 #include <string>
+#include <vector>
 
-#include "fileio.hpp"
+#include "daxpy.hpp"
 #include "parser.h"
+#include "vector_io.hpp"
 
 using namespace std;
-void daxpy(int n, double a, double *x, double *y) {
 
-    if (n <= 0 || a == 0.0) {
-        return;
+bool read_block_pair(ifstream &file_x, ifstream &file_y, size_t count, double *x, double *y) {
+    file_x.read(reinterpret_cast<char*>(x), count * sizeof(double));
+    file_y.read(reinterpret_cast<char*>(y), count * sizeof(double));
+    return bool(file_x) && bool(file_y);
+}
+
+bool checksum_matches(const VectorFileHeader &header, uint32_t crc) {
+    return header.checksum_type == CHECKSUM_NONE || header.checksum == crc;
+}
+
+int daxpy_streaming(size_t N, double a, const string &fname_x, const string &fname_y, const string &fname_d, size_t block_size, bool verify) {
+    /*
+    Out-of-core daxpy
+    x and y are read in blocks of block_size elements, while the current
+    block is computed and written to fname_d the next one is already
+    being read by a second thread (double buffering). Peak memory is four
+    blocks whatever N is, and since daxpy is element-wise the result is
+    bit-identical to the in-memory path. The checksums of the inputs
+    (when verify is set) and of the output are accumulated block by
+    block, the output header is rewritten with its checksum at the end.
+    */
+    VectorFileHeader header_x = read_vector_header(fname_x);
+    VectorFileHeader header_y = read_vector_header(fname_y);
+    ifstream file_x(fname_x, ios::binary);
+    ifstream file_y(fname_y, ios::binary);
+    ofstream file_d(fname_d, ios::binary);
+    if (!file_x || !file_y || !file_d) {
+        cerr << "Error: cannot open <" << fname_x << ">, <" << fname_y << "> or <" << fname_d << ">" << endl;
+        return EXIT_FAILURE;
+    }
+    file_x.seekg(header_x.payload_offset);
+    file_y.seekg(header_y.payload_offset);
+    VectorFileHeader header_d = make_vector_header(N, nullptr);
+    vector<char> block = vector_header_block(header_d);
+    file_d.write(block.data(), block.size());
+    uint32_t crc_x = 0, crc_y = 0, crc_d = 0;
+
+    vector<double> x[2], y[2];
+    for (int b = 0; b < 2; b++) {
+        x[b].resize(min(block_size, N));
+        y[b].resize(min(block_size, N));
+    }
+
+    cout << "Streaming daxpy in blocks of " << block_size << " elements into <" << fname_d << "> ...";
+    size_t count = min(block_size, N);
+    future<bool> next = async(launch::async, read_block_pair, ref(file_x), ref(file_y), count, x[0].data(), y[0].data());
+    int cur = 0;
+    for (size_t offset = 0; offset < N; offset += block_size, cur = 1 - cur) {
+        if (!next.get()) {
+            cerr << "Error: failed to read data from <" << fname_x << "> or <" << fname_y << ">" << endl;
+            return EXIT_FAILURE;
+        }
+
+        // Start reading the next block into the other buffers
+        size_t next_offset = offset + block_size;
+        if (next_offset < N) {
+            size_t next_count = min(block_size, N - next_offset);
+            next = async(launch::async, read_block_pair, ref(file_x), ref(file_y), next_count, x[1 - cur].data(), y[1 - cur].data());
+        }
+
+        count = min(block_size, N - offset);
+        if (verify) {
+            crc_x = crc32c(crc_x, x[cur].data(), count * sizeof(double));
+            crc_y = crc32c(crc_y, y[cur].data(), count * sizeof(double));
+        }
+        daxpy(count, a, x[cur].data(), y[cur].data());
+        crc_d = crc32c(crc_d, y[cur].data(), count * sizeof(double));
+        file_d.write(reinterpret_cast<const char*>(y[cur].data()), count * sizeof(double));
+        if (!file_d) {
+            cerr << "Error: failed to write data to file <" << fname_d << ">" << endl;
+            return EXIT_FAILURE;
+        }
     }
 
-    int m = n % 4;
-    for (int i = 0; i < m; i++) {
-        y[i] += a * x[i];
+    header_d.checksum_type = CHECKSUM_CRC32C;
+    header_d.checksum = crc_d;
+    block = vector_header_block(header_d);
+    file_d.seekp(0);
+    file_d.write(block.data(), block.size());
+    if (!file_d) {
+        cerr << "Error: failed to write data to file <" << fname_d << ">" << endl;
+        return EXIT_FAILURE;
     }
+    cout << " done." << endl;
 
-    for (int i = m; i < n; i += 4) {
-        y[i] += a * x[i];
-        y[i + 1] += a * x[i + 1];
-        y[i + 2] += a * x[i + 2];
-        y[i + 3] += a * x[i + 3];
+    if (verify && !(checksum_matches(header_x, crc_x) && checksum_matches(header_y, crc_y))) {
+        cerr << "Error: checksum mismatch in <" << fname_x << "> or <" << fname_y << ">" << endl;
+        return EXIT_FAILURE;
     }
+    return EXIT_SUCCESS;
+}
+
+int daxpy_async(size_t N, double a, const string &fname_x, const string &fname_y, const string &fname_d, bool verify) {
+    /*
+    In-memory daxpy with asynchronous, segmented I/O
+    All the segment reads of x and y are queued at once and kept in
+    flight by AsyncVectorIO. As soon as both halves of a segment have
+    arrived it is computed and its write to fname_d is queued, so
+    reading, computing and writing overlap instead of running one after
+    the other.
+    */
+    // Left uninitialised, every element is overwritten by the reads
+    unique_ptr<double[]> x(new double[N]), y(new double[N]);
+
+    AsyncVectorIO io(N);
+    io.read(fname_x, x.get(), verify);
+    io.read(fname_y, y.get(), verify);
+    int file_d = io.dump(fname_d);
+    cout << "Asynchronous daxpy (" << io.backend() << ") into <" << fname_d << "> ...";
+    size_t offset, count;
+    while (io.wait_segment(offset, count)) {
+        daxpy(count, a, x.get() + offset, y.get() + offset);
+        io.dump_segment(file_d, offset, count, y.get());
+    }
+    io.finish();
+    cout << " done." << endl;
+    return EXIT_SUCCESS;
 }
 
 int main(int argc, char* argv[]) {
@@ -30,7 +137,10 @@ int main(int argc, char* argv[]) {
     string fname_x = "";
     string fname_y = "";
     string fname_prefix = "";
-    size_t N = 0;
+    size_t N = 0;          // 0 = take it from the header of fname_x
+    size_t block_size = 0; // 0 = load x and y fully in memory
+    string io = "sync";    // in-memory I/O: sync (x mmapped) or async
+    bool verify = false;   // check the checksums of x and y
     double a = 0.0;
 
     // Read config from file
@@ -53,32 +163,54 @@ int main(int argc, char* argv[]) {
             a = atof(co->value);
         } else if (strcmp(co->key, "prefix") == 0) {
             fname_prefix = co->value;
+        } else if (strcmp(co->key, "block_size") == 0) {
+            block_size = strtoull(co->value, NULL, 10);
+        } else if (strcmp(co->key, "io") == 0) {
+            io = co->value;
+        } else if (strcmp(co->key, "verify") == 0) {
+            verify = atoi(co->value) != 0;
         }
         
         if (co->prev != NULL) co = co->prev;
         else break;
     }
 
-    // Allocate memory on the heap
-    double *x = new double[N];
+    // The files say how long they are, N in the config is only checked
+    VectorFileHeader header_x = read_vector_header(fname_x);
+    if (N == 0)
+        N = header_x.length;
+    check_vector_length(fname_x, header_x, N);
+    check_vector_length(fname_y, read_vector_header(fname_y), N);
+
+    string fname_d = fname_prefix + "_N" + to_string(N) + "_d.dat";
+    if (block_size > 0)
+        return daxpy_streaming(N, a, fname_x, fname_y, fname_d, block_size, verify);
+    if (io == "async")
+        return daxpy_async(N, a, fname_x, fname_y, fname_d, verify);
+    if (io != "sync") {
+        cerr << "[error] unknown io <" << io << ">, use sync or async" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Allocate memory on the heap for y only, x is never written
+    // and is used directly from the memory-mapped file
     double *y = new double[N];
 
     // Check if memory allocation was successful
-    if (x == nullptr || y == nullptr) {
+    if (y == nullptr) {
         std::cerr << "Memory allocation failed" << std::endl;
         return 1;
     }
 
     // Initialize x and y
     // reading x and y
-    read_vector_binary(N, fname_x, x);
-    read_vector_binary(N, fname_y, y);
+    MappedVector x(N, fname_x, verify);
+    read_vector_binary(N, fname_y, y, verify);
 
-    daxpy(N, a, x, y);
+    daxpy(N, a, x.data(), y);
 
-    dump_vector_binary(N, fname_prefix + "_N" + to_string(N) + "_d.dat", y);
+    dump_vector_binary(N, fname_d, y);
 
-    delete[] x;
     delete[] y;
 
     return 0;
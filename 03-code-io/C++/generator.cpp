@@ -1,23 +1,17 @@
+#include <algorithm>
+#include <future>
 #include <iostream>
 #include <boost/program_options.hpp>
 
-#include "fileio.hpp"
+#include "vector_io.hpp"
 
 namespace po = boost::program_options;
 
-void generate_vector(int N, double * &v, double init_value) {
-    // allocate memory for vector if not already allocated
-    if (v == nullptr) {
-        v = new double[N];
-        if (v == nullptr) {
-            std::cerr << "Memory allocation failed\n";
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    // else we assume the memory is already allocated 
-    // and initialize vector
-    for (int i = 0; i < N; i++) *(v + i) = init_value;
+void generate_vector(size_t N, const std::string &fname, double init_value) {
+    // written block by block, the vector never exists in memory
+    dump_vector_binary_streaming(N, fname, [init_value](size_t, size_t count, double *block) {
+        std::fill_n(block, count, init_value);
+    });
 }
 
 int main(int argv, char *argc[]) {
@@ -52,19 +46,15 @@ int main(int argv, char *argc[]) {
     std::string fname_prefix = vm["fname_prefix"].as<std::string>();
     std::cout << "Generating vectors with N=" << N << " elements on files " << fname_prefix << std::endl;
 
-    double *vec = nullptr;
-    std::cout << "Generating vector X ..." << std::endl;
-    generate_vector(N, vec, 0.1);
-
-    std::string filename = fname_prefix + "_N" + std::to_string(N) + "_x.dat";
-    dump_vector_binary(N, filename, vec);
-
-    std::cout << "Generating vector Y ...\n";
-    generate_vector(N, vec, 7.1);
-    filename = fname_prefix + "_N" + std::to_string(N) + "_y.dat";
-    dump_vector_binary(N, filename, vec);
-    // clean up
-    delete[] vec;
+    // x and y are generated and written concurrently
+    std::string filename_x = fname_prefix + "_N" + std::to_string(N) + "_x.dat";
+    std::string filename_y = fname_prefix + "_N" + std::to_string(N) + "_y.dat";
+    std::cout << "Generating vector X into <" << filename_x << "> ..." << std::endl;
+    std::cout << "Generating vector Y into <" << filename_y << "> ..." << std::endl;
+    auto x_done = std::async(std::launch::async, generate_vector, N, filename_x, 0.1);
+    generate_vector(N, filename_y, 7.1);
+    x_done.get();
+    std::cout << "done." << std::endl;
     return 0;
 
 }
\ No newline at end of file
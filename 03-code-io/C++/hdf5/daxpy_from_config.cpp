@@ -1,28 +1,11 @@
 #include <iostream>
 #include <string>
 
+#include "daxpy.hpp"
 #include "fileio.hpp"
 #include "../parser.h"
 
 using namespace std;
-void daxpy(int n, double a, double *x, double *y) {
-
-    if (n <= 0 || a == 0.0) {
-        return;
-    }
-
-    int m = n % 4;
-    for (int i = 0; i < m; i++) {
-        y[i] += a * x[i];
-    }
-
-    for (int i = m; i < n; i += 4) {
-        y[i] += a * x[i];
-        y[i + 1] += a * x[i + 1];
-        y[i + 2] += a * x[i + 2];
-        y[i + 3] += a * x[i + 3];
-    }
-}
 
 int main(int argc, char* argv[]) {
 
@@ -32,6 +15,10 @@ int main(int argc, char* argv[]) {
     string fname_prefix = "";
     size_t N = 0;
     double a = 0.0;
+    // layout of the output dataset, see dump_vector_hdf5
+    hsize_t chunk_size = 0;
+    int deflate_level = 0;
+    bool shuffle = false;
 
     // Read config from file
     config_option_t co;
@@ -53,6 +40,12 @@ int main(int argc, char* argv[]) {
             a = atof(co->value);
         } else if (strcmp(co->key, "prefix") == 0) {
             fname_prefix = co->value;
+        } else if (strcmp(co->key, "chunk_size") == 0) {
+            chunk_size = strtoull(co->value, NULL, 10);
+        } else if (strcmp(co->key, "deflate") == 0) {
+            deflate_level = atoi(co->value);
+        } else if (strcmp(co->key, "shuffle") == 0) {
+            shuffle = atoi(co->value) != 0;
         }
         
         if (co->prev != NULL) co = co->prev;
@@ -70,10 +63,17 @@ int main(int argc, char* argv[]) {
     daxpy(N, a, x, y);
 
     cout << "[info] look at first result: d[0] = " << y[0] << endl;
-    dump_vector_hdf5(N, fname_prefix + "_N" + to_string(N) + "_d.h5", "vector_data", y);
-    read_vector_hdf5(N, fname_prefix + "_N" + to_string(N) + "_d.h5", "vector_data", x);
+    string fname_d = fname_prefix + "_N" + to_string(N) + "_d.h5";
+    dump_vector_hdf5(N, fname_d, "vector_data", y, chunk_size, deflate_level, shuffle);
+    read_vector_hdf5(N, fname_d, "vector_data", x);
     cout << "[info] look at first read result: d[0] = " << x[0] << endl;
 
+    // partial read: only the chunk holding the last element is fetched
+    if (N > 0) {
+        read_vector_hdf5_slab(fname_d, "vector_data", N - 1, 1, x);
+        cout << "[info] look at last read result: d[" << N - 1 << "] = " << x[0] << endl;
+    }
+
     delete[] x;
     delete[] y;
 
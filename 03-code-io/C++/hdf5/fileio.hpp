@@ -1,33 +1,133 @@
 #ifndef FILEIO_HPP
 #define FILEIO_HPP
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <hdf5.h>
 
-void read_vector_hdf5(int N, const std::string fname, const std::string dataset_name, double * &vector) {
-    hid_t file_id, dataset_id;
+/*
+The fapl_id/dxpl_id arguments are the file access and dataset transfer
+property lists, H5P_DEFAULT for plain serial I/O. With an MPI-IO file
+access list (H5Pset_fapl_mpio) the functions are collective: every rank
+of the communicator calls them, each with its own slab.
+*/
+
+[[noreturn]] void fileio_abort(hid_t fapl_id = H5P_DEFAULT) {
+    // With an MPI-IO fapl_id the other ranks may be blocked in the same
+    // collective call: exit() would leave them hanging, MPI_Abort takes
+    // the whole communicator down
+#ifdef H5_HAVE_PARALLEL
+    if (fapl_id != H5P_DEFAULT && H5Pget_driver(fapl_id) == H5FD_MPIO) {
+        MPI_Comm comm = MPI_COMM_WORLD;
+        MPI_Info info;
+        H5Pget_fapl_mpio(fapl_id, &comm, &info);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+#else
+    (void)fapl_id;
+#endif
+    exit(EXIT_FAILURE);
+}
+
+hsize_t vector_length_hdf5(const std::string fname, const std::string dataset_name, hid_t fapl_id = H5P_DEFAULT) {
+    hid_t file_id, dataset_id, dataspace_id;
+    hsize_t dims[1] = {0};
+
+    file_id = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, fapl_id);
+    if (file_id < 0) {
+        std::cout << "Error opening file " << fname << std::endl;
+        fileio_abort(fapl_id);
+    }
+    dataset_id = H5Dopen(file_id, dataset_name.c_str(), H5P_DEFAULT);
+    dataspace_id = H5Dget_space(dataset_id);
+    int rank = H5Sget_simple_extent_dims(dataspace_id, dims, NULL);
+
+    H5Sclose(dataspace_id);
+    H5Dclose(dataset_id);
+    H5Fclose(file_id);
+
+    if (rank != 1) {
+        std::cout << "Error: dataset " << dataset_name << " in file " << fname << " is not a vector" << std::endl;
+        fileio_abort(fapl_id);
+    }
+    return dims[0];
+}
+
+hid_t select_vector_slab(hid_t file_space, hsize_t offset, hsize_t count) {
+    // Selects [offset, offset + count) in file_space and returns the
+    // matching memory dataspace (negative on error). An empty slab
+    // selects nothing, so that a rank without data can still take part
+    // in collective I/O.
+    hsize_t start[1] = {offset}, size[1] = {count};
+    hid_t mem_space = H5Screate_simple(1, size, NULL);
     herr_t status;
+    if (count == 0) {
+        H5Sselect_none(mem_space);
+        status = H5Sselect_none(file_space);
+    } else {
+        status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, size, NULL);
+    }
+    if (status < 0) {
+        H5Sclose(mem_space);
+        return -1;
+    }
+    return mem_space;
+}
+
+void read_vector_hdf5_slab(const std::string fname, const std::string dataset_name, hsize_t offset, hsize_t count, double * &vector,
+                           hid_t fapl_id = H5P_DEFAULT, hid_t dxpl_id = H5P_DEFAULT) {
+    /*
+    Read the hyperslab [offset, offset + count) of a 1D dataset
+    Only the chunks overlapping the slab are read (and decompressed),
+    so a worker can pull its own slice of a vector without touching the
+    rest of the file. vector is allocated with count elements if null.
+    */
+    hid_t file_id, dataset_id, file_space, mem_space;
+    herr_t status = -1;
+    hsize_t dims[1] = {0};
 
     // IO
-    file_id = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    file_id = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, fapl_id);
+    if (file_id < 0) {
+        std::cout << "Error opening file " << fname << std::endl;
+        fileio_abort(fapl_id);
+    }
     dataset_id = H5Dopen(file_id, dataset_name.c_str(), H5P_DEFAULT);
+    file_space = H5Dget_space(dataset_id);
+    H5Sget_simple_extent_dims(file_space, dims, NULL);
+    if (offset + count > dims[0]) {
+        std::cout << "Error: slab [" << offset << ", " << offset + count << ") is out of dataset " << dataset_name
+                  << " of size " << dims[0] << " in file " << fname << std::endl;
+        H5Sclose(file_space);
+        H5Dclose(dataset_id);
+        H5Fclose(file_id);
+        fileio_abort(fapl_id);
+    }
 
     // allocate memory
     if (vector == nullptr) {
-        vector = new double[N];
+        vector = new double[count];
         if (vector == nullptr) {
             std::cout << "Memory allocation failed" << std::endl;
+            H5Sclose(file_space);
             H5Dclose(dataset_id);
             H5Fclose(file_id);
-            exit(EXIT_FAILURE);
+            fileio_abort(fapl_id);
         }
     }
 
-    // read from file
-    status = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, vector);
+    // select the slab in the file, the memory side is contiguous
+    mem_space = select_vector_slab(file_space, offset, count);
+    if (mem_space >= 0) {
+        status = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, mem_space, file_space, dxpl_id, vector);
+    }
 
     // close
+    if (mem_space >= 0)
+        H5Sclose(mem_space);
+    H5Sclose(file_space);
     H5Dclose(dataset_id);
     H5Fclose(file_id);
 
@@ -35,20 +135,57 @@ void read_vector_hdf5(int N, const std::string fname, const std::string dataset_
         std::cout << "Error reading dataset " << dataset_name << " from file " << fname << std::endl;
         delete[] vector;
         vector = nullptr;
-        exit(EXIT_FAILURE);
+        fileio_abort(fapl_id);
     }
 }
 
-void dump_vector_hdf5(int N, const std::string fname, const std::string dataset_name, const double *vect) {
-    hid_t file_id, dataset_id, dataspace_id;
+void read_vector_hdf5(int N, const std::string fname, const std::string dataset_name, double * &vector) {
+    // the whole vector, which must hold N elements
+    hsize_t length = vector_length_hdf5(fname, dataset_name);
+    if (length != (hsize_t)N) {
+        std::cout << "Error: dataset " << dataset_name << " in file " << fname << " holds " << length
+                  << " elements, expected " << N << std::endl;
+        fileio_abort();
+    }
+    read_vector_hdf5_slab(fname, dataset_name, 0, N, vector);
+}
+
+void dump_vector_hdf5(int N, const std::string fname, const std::string dataset_name, const double *vect,
+                      hsize_t chunk_size = 0, int deflate_level = 0, bool shuffle = false) {
+    /*
+    chunk_size = 0 writes a contiguous dataset, otherwise it is chunked
+    in chunk_size elements, which is the unit partial reads fetch and
+    filters work on. deflate_level 1-9 compresses the chunks (zlib),
+    shuffle regroups the bytes of the doubles first, which usually helps
+    the compression of floating point data. The filters need chunking:
+    if they are asked for without a chunk size, 65536 elements are used.
+    */
+    hid_t file_id, dataset_id, dataspace_id, dcpl_id;
     hsize_t dims[1] = {(hsize_t)N};
 
     std::cout << "Writing file <" << fname << "> ..." << std::endl;
 
+    // dataset layout and filters
+    dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    if (chunk_size == 0 && (deflate_level > 0 || shuffle))
+        chunk_size = 65536;
+    if (chunk_size > 0 && N > 0) {
+        hsize_t chunk[1] = {std::min(chunk_size, dims[0])};
+        H5Pset_chunk(dcpl_id, 1, chunk);
+        if (shuffle)
+            H5Pset_shuffle(dcpl_id);
+        if (deflate_level > 0) {
+            if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+                H5Pset_deflate(dcpl_id, deflate_level);
+            else
+                std::cout << "[warning] deflate filter not available, writing uncompressed" << std::endl;
+        }
+    }
+
     // create a new file & dataset
     file_id = H5Fcreate(fname.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
     dataspace_id = H5Screate_simple(1, dims, NULL);
-    dataset_id = H5Dcreate(file_id, dataset_name.c_str(), H5T_NATIVE_DOUBLE, dataspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    dataset_id = H5Dcreate(file_id, dataset_name.c_str(), H5T_NATIVE_DOUBLE, dataspace_id, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
 
     // write
     H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, vect);
@@ -56,9 +193,46 @@ void dump_vector_hdf5(int N, const std::string fname, const std::string dataset_
     // closing operations
     H5Dclose(dataset_id);
     H5Sclose(dataspace_id);
+    H5Pclose(dcpl_id);
     H5Fclose(file_id);
 
     std::cout << "done." << std::endl;
 }
 
-#endif // FILEIO_HPP
\ No newline at end of file
+void dump_vector_hdf5_slab(hsize_t N, const std::string fname, const std::string dataset_name, hsize_t offset, hsize_t count,
+                           const double *vect, hid_t fapl_id = H5P_DEFAULT, hid_t dxpl_id = H5P_DEFAULT) {
+    /*
+    Create fname with a contiguous dataset of N elements and write
+    [offset, offset + count) of it from vect. Meant to be called
+    collectively with an MPI-IO fapl_id, the ranks' slabs covering the
+    dataset between them.
+    */
+    hid_t file_id, dataset_id, file_space, mem_space;
+    herr_t status = -1;
+    hsize_t dims[1] = {N};
+
+    file_id = H5Fcreate(fname.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
+    if (file_id < 0) {
+        std::cout << "Error creating file " << fname << std::endl;
+        fileio_abort(fapl_id);
+    }
+    file_space = H5Screate_simple(1, dims, NULL);
+    dataset_id = H5Dcreate(file_id, dataset_name.c_str(), H5T_NATIVE_DOUBLE, file_space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+    mem_space = select_vector_slab(file_space, offset, count);
+    if (mem_space >= 0) {
+        status = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, mem_space, file_space, dxpl_id, vect);
+        H5Sclose(mem_space);
+    }
+
+    H5Dclose(dataset_id);
+    H5Sclose(file_space);
+    H5Fclose(file_id);
+
+    if (status < 0) {
+        std::cout << "Error writing dataset " << dataset_name << " to file " << fname << std::endl;
+        fileio_abort(fapl_id);
+    }
+}
+
+#endif // FILEIO_HPP
@@ -29,7 +29,10 @@ int main(int argv, char *argc[]) {
     desc.add_options()
         ("help,h", "produce help message")
         ("N,n", po::value<int>()->default_value(10), "size of vectors")
-        ("fname_prefix,f", po::value<std::string>()->default_value("vector"), "prefix for output files");
+        ("fname_prefix,f", po::value<std::string>()->default_value("vector"), "prefix for output files")
+        ("chunk,c", po::value<hsize_t>()->default_value(0), "chunk size in elements (0: contiguous dataset)")
+        ("deflate,z", po::value<int>()->default_value(0), "deflate compression level, 0-9")
+        ("shuffle,s", "shuffle filter before compression");
     po::variables_map vm;
 
     po::store(po::parse_command_line(argv, argc, desc), vm);
@@ -51,6 +54,9 @@ int main(int argv, char *argc[]) {
     int N = vm["N"].as<int>();
     std::string fname_prefix = vm["fname_prefix"].as<std::string>();
     std::string dataset_name = "vector_data";
+    hsize_t chunk_size = vm["chunk"].as<hsize_t>();
+    int deflate_level = vm["deflate"].as<int>();
+    bool shuffle = vm.count("shuffle") > 0;
     std::cout << "Generating vectors with N=" << N << " elements on files " << fname_prefix << std::endl;
 
     double *vec = new double[N];
@@ -62,12 +68,12 @@ int main(int argv, char *argc[]) {
     generate_vector(N, vec, 0.1);
 
     std::string filename = fname_prefix + "_N" + std::to_string(N) + "_x.h5";
-    dump_vector_hdf5(N, filename, dataset_name, vec);
+    dump_vector_hdf5(N, filename, dataset_name, vec, chunk_size, deflate_level, shuffle);
 
     std::cout << "Generating vector Y ...\n";
     generate_vector(N, vec, 7.1);
     filename = fname_prefix + "_N" + std::to_string(N) + "_y.h5";
-    dump_vector_hdf5(N, filename, dataset_name, vec);
+    dump_vector_hdf5(N, filename, dataset_name, vec, chunk_size, deflate_level, shuffle);
     // clean up
     delete[] vec;
     return 0;
@@ -1,74 +1,25 @@
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <string>
 
-#include "fileio.hpp"
+#include "daxpy.hpp"
+#include "daxpy_sum.hpp"
+#include "sum.hpp"
+#include "moments.hpp"
 #include "parser.h"
+#include "vector_io.hpp"
 
 using namespace std;
 
-double KahanBabushkaNeumaierSum(const double *vec, int n) {
-    /*
-    Kahan-Babushka-Neumaier summation algorithm
-    This algorithm is a modification of the Kahan summation algorithm that uses two variables
-    to keep track of the compensation for lost low-order bits.
-    */
-
-    double sum = 0.0, c = 0.0;
-
-    for (int i = 0; i < n; i++) {
-        double t = sum + vec[i];
-        if (abs(sum) >= abs(vec[i])) {
-            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
-        } else {
-            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
-        }
-        sum = t;
-    }
-    return sum + c;
-}
-
-double stdev(const double *vec, int n) {
-    /*
-    Standard deviation calculation
-    This function calculates the standard deviation of a vector using the Kahan-Babushka-Neumaier summation algorithm.
-    */
-
-    double mean = KahanBabushkaNeumaierSum(vec, n) / n;
-    double sum_sq_diff = 0.0;
-
-    for (int i = 0; i < n; i++) {
-        sum_sq_diff += pow(vec[i] - mean, 2);
-    }
-
-    return sqrt(sum_sq_diff / n-1);
-}
-
-void daxpy(int n, double a, double *x, double *y) {
-
-    if (n <= 0 || a == 0.0) {
-        return;
-    }
-
-    int m = n % 4;
-    for (int i = 0; i < m; i++) {
-        y[i] += a * x[i];
-    }
-
-    for (int i = m; i < n; i += 4) {
-        y[i] += a * x[i];
-        y[i + 1] += a * x[i + 1];
-        y[i + 2] += a * x[i + 2];
-        y[i + 3] += a * x[i + 3];
-    }
-}
-
 int main(int argc, char* argv[]) {
 
     string fname_config = "daxpy.conf";
     string if_prefix = "", of_prefix = "";
     size_t N = 0;
     double a = 0.0, mean = 0.0, std = 1.0;
+    bool verify = false; // check the checksums of x and y
+    SumMethod sum_method = SumMethod::KBN; // for the mean
 
     // Read config from file
     config_option_t co;
@@ -92,18 +43,25 @@ int main(int argc, char* argv[]) {
             mean = atof(co->value);
         } else if (strcmp(co->key, "std") == 0) {
             std = atof(co->value);
+        } else if (strcmp(co->key, "verify") == 0) {
+            verify = atoi(co->value) != 0;
+        } else if (strcmp(co->key, "sum") == 0) {
+            if (!sum_method_from_name(co->value, sum_method)) {
+                cerr << "Unknown summation method " << co->value << " (kbn, reproducible or exact)" << endl;
+                return EXIT_FAILURE;
+            }
         }
         
         if (co->prev != NULL) co = co->prev;
         else break;
     }
 
-    // Allocate memory on the heap
-    double *x = new double[N];
+    // Allocate memory on the heap for y only, x is never written
+    // and is used directly from the memory-mapped file
     double *y = new double[N];
 
     // Check if memory allocation was successful
-    if (x == nullptr || y == nullptr) {
+    if (y == nullptr) {
         std::cerr << "Memory allocation failed" << std::endl;
         return 1;
     }
@@ -112,17 +70,30 @@ int main(int argc, char* argv[]) {
     // reading x and y
     string fname_x = if_prefix + "_N" + to_string(N) + "_x.dat";
     string fname_y = if_prefix + "_N" + to_string(N) + "_y.dat";
-    read_vector_binary(N, fname_x, x);
-    read_vector_binary(N, fname_y, y);
-
-    daxpy(N, a, x, y);
+    MappedVector x(N, fname_x, verify);
+    read_vector_binary(N, fname_y, y, verify);
+
+    // daxpy, its KBN sum and the moments of the result block by block,
+    // each block still in cache when the moments read it: one sweep of y
+    const size_t block = 1 << 15;
+    CompensatedSum kbn_sum = {0.0, 0.0};
+    Moments moments;
+    moments_clear(moments);
+    for (size_t start = 0; start < N; start += block) {
+        int len = (int)min(block, N - start);
+        kbn_sum = compensated_merge(kbn_sum, daxpy_sum_partial(len, a, x.data() + start, y + start));
+        moments_add(moments, y + start, len);
+    }
 
     string ofname = of_prefix + "_N" + to_string(N) + "_d.dat";
     dump_vector_binary(N, ofname, y);
 
     // Check the result
-    double exp_mean = KahanBabushkaNeumaierSum(y, N) / N;
-    double exp_std = stdev(y, N);
+    // the mean from the configured summation method, the KBN sum comes
+    // with the sweep above, the others cost a second pass
+    double sum = sum_method == SumMethod::KBN ? kbn_sum.sum + kbn_sum.c : sum_with(sum_method, y, N);
+    double exp_mean = sum / N;
+    double exp_std = moments_stdev(moments);
     double th_std = std * sqrt(a*a + 1.);
 
     int tol = 1; // tolerance for the mean in terms of sigmas
@@ -133,7 +104,6 @@ int main(int argc, char* argv[]) {
     cout << "Expected mean +- std:\t\t" << mean << " +- " << th_std << endl;
 
 
-    delete[] x;
     delete[] y;
 
     return 0;
@@ -1,29 +1,21 @@
+#include <cstdint>
+#include <future>
 #include <iostream>
-#include <random>
 #include <string>
 
-#include "fileio.hpp"
 #include "parser.h"
+#include "rng.hpp"
+#include "vector_io.hpp"
 
 using namespace std;
 
-void generate_vector(int N, double * &v, double mean, double std) {
-    // allocate memory for vector if not already allocated
-    if (v == nullptr) {
-        v = new double[N];
-        if (v == nullptr) {
-            std::cerr << "Memory allocation failed\n";
-            exit(EXIT_FAILURE);
-        }
-    }
-
-    // initialize random number generator
-    default_random_engine generator;
-    normal_distribution<double> d(mean, std);
-
-    // else we assume the memory is already allocated 
-    // and initialize vector
-    for (int i = 0; i < N; i++) *(v + i) = d(generator);
+void generate_vector(size_t N, const string &fname, double mean, double std, RngStream stream) {
+    // Written block by block, the vector never exists in memory.
+    // Counter-based generator: every element depends only on
+    // (seed, stream, index), whatever the block size or thread count
+    dump_vector_binary_streaming(N, fname, [&](size_t, size_t count, double *block) {
+        fill_normal(block, count, mean, std, stream);
+    });
 }
 
 int main(int argv, char *argc[]) {
@@ -34,6 +26,7 @@ int main(int argv, char *argc[]) {
     string of_prefix = "";
     size_t N = 0;
     double mean = 0.0, std = 1.0;
+    uint64_t seed = 0;
 
     // Read config from file
     config_option_t co;
@@ -53,6 +46,8 @@ int main(int argv, char *argc[]) {
             mean = atof(co->value);
         } else if (strcmp(co->key, "std") == 0) {
             std = atof(co->value);
+        } else if (strcmp(co->key, "seed") == 0) {
+            seed = strtoull(co->value, NULL, 10);
         }
         
         if (co->prev != NULL) co = co->prev;
@@ -60,21 +55,16 @@ int main(int argv, char *argc[]) {
     }
     cout << "Generating vectors with N=" << N << " elements on files " << of_prefix << endl;
 
-    double *vec = nullptr;
-    cout << "Generating vector X ..." << endl;
-    generate_vector(N, vec, mean, std);
-
-    string filename = of_prefix + "_N" + to_string(N) + "_x.dat";
-    dump_vector_binary(N, filename, vec);
-
-    cout << "Generating vector Y ...\n";
-    generate_vector(N, vec, mean, std);
-
-    filename = of_prefix + "_N" + to_string(N) + "_y.dat";
-    dump_vector_binary(N, filename, vec);
-    
-    // clean up
-    delete[] vec;
+    // x and y are generated and written concurrently
+    string filename_x = of_prefix + "_N" + to_string(N) + "_x.dat";
+    string filename_y = of_prefix + "_N" + to_string(N) + "_y.dat";
+    cout << "Generating vector X into <" << filename_x << "> ..." << endl;
+    cout << "Generating vector Y into <" << filename_y << "> ..." << endl;
+    RngStream stream_x = {seed, 0, 0}, stream_y = {seed, 1, 0};
+    auto x_done = async(launch::async, generate_vector, N, filename_x, mean, std, stream_x);
+    generate_vector(N, filename_y, mean, std, stream_y);
+    x_done.get();
+    cout << "done." << endl;
     return 0;
 
 }
\ No newline at end of file
@@ -1,6 +1,12 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <eigen3/Eigen/Dense>
+#include <vector>
+
+#include "sum.hpp"
 
 using namespace std;
 
@@ -31,25 +37,21 @@ double Kahan_sum(const double *vec, int n) {
     return sum;
 }
 
-double KahanBabushkaNeumaierSum(const double *vec, int n) {
-    /*
-    Kahan-Babushka-Neumaier summation algorithm
-    This algorithm is a modification of the Kahan summation algorithm that uses two variables
-    to keep track of the compensation for lost low-order bits.
-    */
-
-    double sum = 0.0, c = 0.0;
-
-    for (int i = 0; i < n; i++) {
-        double t = sum + vec[i];
-        if (abs(sum) >= abs(vec[i])) {
-            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
-        } else {
-            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
-        }
-        sum = t;
+double time_sum(double (*sum)(const double *, int), const double *vec, int n, int repeats, double &result) {
+    // best wall time in seconds over repeats runs
+    double best = 1e300;
+    for (int r = 0; r < repeats; r++) {
+        auto start = chrono::high_resolution_clock::now();
+        result = sum(vec, n);
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
     }
-    return sum + c;
+    return best;
+}
+
+double KBN_scalar(const double *vec, int n) {
+    CompensatedSum s = KahanBabushkaNeumaierSum_scalar(vec, n);
+    return s.sum + s.c;
 }
 
 int main() {
@@ -73,6 +75,41 @@ int main() {
     cout << "Kahan sum: " << kahan_result << endl;
     cout << "Kahan-Babushka-Neumaier sum: " << kahan_babushka_result << endl;
     cout << "eigen3 sum: " << eigen_result << endl;
-    
+    cout << "Exact sum: " << ExactSum(vec, n) << endl;
+
+    // KBN is not exact either: 1e16 + 1 is halfway between two doubles,
+    // the 1e-100 decides it, but it is lost in the compensation term
+    double harder[] = {1.0, 1.0e-100, 1.0e16};
+    cout << endl << "Sum of {1, 1e-100, 1e16}:" << endl;
+    cout << setprecision(17);
+    cout << "Kahan-Babushka-Neumaier sum: " << KahanBabushkaNeumaierSum(harder, 3) << endl;
+    cout << "Exact sum: " << ExactSum(harder, 3) << endl;
+    cout << setprecision(6);
+
+    // Compensation is cheap once vectorized: time the sums on a large,
+    // ill-conditioned vector (alternating signs, magnitudes over 16 decades)
+    const int n_large = 1 << 24;
+    const int repeats = 5;
+    vector<double> large(n_large);
+    for (int i = 0; i < n_large; i++) {
+        large[i] = (i % 2 ? -1.0 : 1.0) * pow(10.0, i % 17) * (1.0 + 1.0e-3 * (i % 1000));
+    }
+
+    double r_naive, r_kbn, r_simd, r_repro, r_exact;
+    double t_naive = time_sum(naive_sum, large.data(), n_large, repeats, r_naive);
+    double t_kbn = time_sum(KBN_scalar, large.data(), n_large, repeats, r_kbn);
+    double t_simd = time_sum(KahanBabushkaNeumaierSum, large.data(), n_large, repeats, r_simd);
+    double t_repro = time_sum(ReproducibleSum, large.data(), n_large, repeats, r_repro);
+    double t_exact = time_sum(ExactSum, large.data(), n_large, repeats, r_exact);
+
+    cout << endl << "Sum of " << n_large << " elements, best of " << repeats << " runs:" << endl;
+    cout << "Naive sum:    " << setprecision(17) << r_naive << setprecision(4) << " in " << t_naive * 1e3 << " ms" << endl;
+    cout << "KBN (scalar): " << setprecision(17) << r_kbn << setprecision(4) << " in " << t_kbn * 1e3 << " ms" << endl;
+    cout << "KBN (" << isa_name(sum_selected_isa()) << "): " << setprecision(17) << r_simd << setprecision(4)
+         << " in " << t_simd * 1e3 << " ms, " << t_kbn / t_simd << "x the scalar KBN" << endl;
+    cout << "Reproducible: " << setprecision(17) << r_repro << setprecision(4) << " in " << t_repro * 1e3 << " ms" << endl;
+    cout << "Exact:        " << setprecision(17) << r_exact << setprecision(4) << " in " << t_exact * 1e3 << " ms ("
+         << 8e-6 * n_large / t_exact << " MB/s)" << endl;
+
     return 0;
 }
\ No newline at end of file
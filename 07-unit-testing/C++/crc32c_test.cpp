@@ -0,0 +1,54 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "crc32c.hpp"
+
+TEST(Crc32cTest, KnownValue) {
+    // check value of the CRC-32C catalogue entry
+    const char digits[] = "123456789";
+    EXPECT_EQ(crc32c_scalar(0, digits, 9), 0xe3069283u);
+    EXPECT_EQ(crc32c(0, digits, 9), 0xe3069283u);
+    EXPECT_EQ(crc32c(0, digits, 0), 0u);
+}
+
+TEST(Crc32cTest, MatchesScalar) {
+    // every length and misalignment around the 8-byte steps
+    std::vector<unsigned char> data(300);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<unsigned char>(i * 131 + 7);
+    }
+    for (size_t start = 0; start < 8; start++) {
+        for (size_t len = 0; start + len <= data.size(); len += 13) {
+            EXPECT_EQ(crc32c(0, data.data() + start, len), crc32c_scalar(0, data.data() + start, len))
+                << "start=" << start << " len=" << len;
+        }
+    }
+}
+
+TEST(Crc32cTest, MatchesScalarLong) {
+    // lengths around the blocks of 3 interleaved streams (3 x 256 and
+    // 3 x 8192 bytes) and their tails
+    std::vector<unsigned char> data(4 * 3 * 8192 + 100);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<unsigned char>(i * 131 + 7);
+    }
+    for (size_t len: {767, 768, 769, 1543, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 776, 4 * 3 * 8192 + 99}) {
+        for (size_t start: {0, 1}) {
+            EXPECT_EQ(crc32c(0, data.data() + start, len), crc32c_scalar(0, data.data() + start, len))
+                << "start=" << start << " len=" << len;
+        }
+    }
+}
+
+TEST(Crc32cTest, Continues) {
+    std::vector<double> data(1000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = 0.5 * i;
+    }
+    uint32_t whole = crc32c(0, data.data(), data.size() * sizeof(double));
+    uint32_t split = crc32c(0, data.data(), 333 * sizeof(double));
+    split = crc32c(split, data.data() + 333, (data.size() - 333) * sizeof(double));
+    EXPECT_EQ(whole, split);
+}
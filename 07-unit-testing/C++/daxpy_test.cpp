@@ -1,41 +1,15 @@
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <iostream>
 #include <chrono>
+#include <vector>
 
 #include <gtest/gtest.h>
 
-
-void daxpy(int n, double a, double *x, double *y) {
-    if (n <= 0 || a == 0.0) {
-        return;
-    }
-
-    for (int i = 0; i < n; i++) {
-        y[i] += a * x[i];
-    }
-}
-
-void daxpy_unrolled(int n, double a, double *x, double *y) {
-
-    if (n <= 0 || a == 0.0) {
-        return;
-    }
-
-    int m = n % 4;
-    for (int i = 0; i < m; i++) {
-        y[i] += a * x[i];
-    }
-
-    for (int i = m; i < n; i += 4) {
-        y[i] += a * x[i];
-        y[i + 1] += a * x[i + 1];
-        y[i + 2] += a * x[i + 2];
-        y[i + 3] += a * x[i + 3];
-    }
-}
-
-
+#include "daxpy.hpp"
+#include "daxpy_sum.hpp"
+#include "sum.hpp"
 
 TEST(DaxpyTest, SmallArray) {
     const int n = 5;
@@ -209,3 +183,137 @@ TEST(DaxpyTest, LargeArray) {
         EXPECT_NEAR(y[i], expected_y[i], 1e-15);
     }
 }
+
+TEST(DaxpyTest, AllKernelsMatchScalar) {
+    const double a = 1.1;
+    const Isa ISAS[] = {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512};
+
+    for (const Isa isa: ISAS) {
+        daxpy_kernel_t kernel = daxpy_kernel(isa);
+        if (kernel == nullptr) {
+            continue; // not supported on this host
+        }
+
+        // cover all the vector widths and remainder lengths
+        for (int n = 1; n <= 67; n++) {
+            std::vector<double> x(n), y(n), expected_y(n);
+            for (int i = 0; i < n; i++) {
+                x[i] = i * 0.1 - 2.0;
+                y[i] = i * 0.2;
+                expected_y[i] = y[i];
+            }
+
+            daxpy_unrolled(n, a, x.data(), expected_y.data());
+            kernel(n, a, x.data(), y.data());
+
+            for (int i = 0; i < n; i++) {
+                EXPECT_EQ(y[i], expected_y[i]) << isa_name(isa) << " n = " << n << " i = " << i;
+            }
+        }
+    }
+}
+
+TEST(DaxpyTest, SelectedKernelIsSupported) {
+    EXPECT_TRUE(isa_supported(daxpy_selected_isa()));
+    EXPECT_NE(daxpy_kernel(daxpy_selected_isa()), nullptr);
+}
+
+TEST(DaxpySumTest, FusedMatchesSeparate) {
+    // same y and the same sums, to the bit, as daxpy followed by the KBN
+    // sum kernel of the same ISA on y and on its squares
+    const double a = 1.1;
+    const Isa ISAS[] = {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512};
+
+    for (const Isa isa: ISAS) {
+        daxpy_sum_kernel_t fused = daxpy_sum_kernel(isa);
+        daxpy_reduce_kernel_t reduce = daxpy_reduce_kernel(isa);
+        if (fused == nullptr) {
+            continue; // not supported on this host
+        }
+        kbn_kernel_t sum = kbn_kernel(isa);
+
+        for (int n = 1; n <= 131; n++) {
+            std::vector<double> x(n), y(n), y_reduce(n), expected_y(n);
+            for (int i = 0; i < n; i++) {
+                x[i] = i * 0.1 - 2.0;
+                y[i] = std::sin(i) * 1e3;
+                expected_y[i] = y_reduce[i] = y[i];
+            }
+
+            daxpy_unrolled(n, a, x.data(), expected_y.data());
+            CompensatedSum expected = sum(expected_y.data(), n);
+            std::vector<double> squares(n);
+            for (int i = 0; i < n; i++) {
+                squares[i] = expected_y[i] * expected_y[i];
+            }
+            CompensatedSum expected_sq = sum(squares.data(), n);
+            CompensatedSum s = fused(n, a, x.data(), y.data());
+            DaxpyReduction r = reduce(n, a, x.data(), y_reduce.data());
+
+            EXPECT_EQ(s.sum, expected.sum) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(s.c, expected.c) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(r.sum.sum, expected.sum) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(r.sum.c, expected.c) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(r.sum_sq.sum, expected_sq.sum) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(r.sum_sq.c, expected_sq.c) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(r.min, *std::min_element(expected_y.begin(), expected_y.end())) << isa_name(isa) << " n = " << n;
+            EXPECT_EQ(r.max, *std::max_element(expected_y.begin(), expected_y.end())) << isa_name(isa) << " n = " << n;
+            for (int i = 0; i < n; i++) {
+                EXPECT_EQ(y[i], expected_y[i]) << isa_name(isa) << " n = " << n << " i = " << i;
+                EXPECT_EQ(y_reduce[i], expected_y[i]) << isa_name(isa) << " n = " << n << " i = " << i;
+            }
+        }
+    }
+}
+
+TEST(DaxpySumTest, Reduction) {
+    const int n = 1001;
+    const double a = -0.5;
+    std::vector<double> x(n), y(n);
+    for (int i = 0; i < n; i++) {
+        x[i] = i;
+        y[i] = 3.0 * i + 1.0; // y becomes 2.5 i + 1
+    }
+
+    // in two pieces, merged
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    daxpy_reduce(300, a, x.data(), y.data(), r);
+    daxpy_reduce(n - 300, a, x.data() + 300, y.data() + 300, r);
+
+    double sum_sq = 0.0;
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(y[i], 2.5 * i + 1.0);
+        sum_sq += y[i] * y[i];
+    }
+    EXPECT_EQ(r.sum.sum + r.sum.c, 2.5 * (n - 1) * n / 2 + n);
+    EXPECT_NEAR(r.sum_sq.sum + r.sum_sq.c, sum_sq, 1e-15 * sum_sq);
+    EXPECT_EQ(r.min, 1.0);
+    EXPECT_EQ(r.max, 2.5 * (n - 1) + 1.0);
+}
+
+TEST(DaxpySumTest, ZeroScalar) {
+    // y is not written, the sum is the sum of y
+    std::vector<double> x = {NAN, 1.0, 2.0}, y = {-0.0, 1.5, 2.5};
+    EXPECT_EQ(daxpy_sum(3, 0.0, x.data(), y.data()), 4.0);
+    EXPECT_TRUE(std::signbit(y[0]));
+
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    daxpy_reduce(3, 0.0, x.data(), y.data(), r);
+    EXPECT_TRUE(std::signbit(y[0]));
+    EXPECT_EQ(r.sum.sum + r.sum.c, 4.0);
+    EXPECT_EQ(r.max, 2.5);
+}
+
+TEST(DaxpySumTest, ZeroLength) {
+    double x = 1.0, y = 2.0;
+    EXPECT_EQ(daxpy_sum(0, 3.0, &x, &y), 0.0);
+    EXPECT_EQ(y, 2.0);
+
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    daxpy_reduce(0, 3.0, &x, &y, r);
+    EXPECT_EQ(r.min, INFINITY);
+    EXPECT_EQ(r.max, -INFINITY);
+}
@@ -0,0 +1,166 @@
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gemm.hpp"
+#include "small_matmul.hpp"
+
+// C = alpha*A*B + beta*C, textbook triple loop
+void reference_gemm(int m, int n, int k, double alpha, const double *a, int lda,
+                    const double *b, int ldb, double beta, double *c, int ldc) {
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int p = 0; p < k; p++) {
+                sum += a[i * lda + p] * b[p * ldb + j];
+            }
+            c[i * ldc + j] = alpha * sum + beta * c[i * ldc + j];
+        }
+    }
+}
+
+void fill(std::vector<double> &v, int seed) {
+    for (size_t i = 0; i < v.size(); i++) {
+        v[i] = std::sin(0.37 * i + seed);
+    }
+}
+
+void expect_gemm_matches(int m, int n, int k, double alpha, double beta) {
+    std::vector<double> a(m * k), b(k * n), c(m * n), expected_c(m * n);
+    fill(a, 1);
+    fill(b, 2);
+    fill(c, 3);
+    expected_c = c;
+
+    reference_gemm(m, n, k, alpha, a.data(), k, b.data(), n, beta, expected_c.data(), n);
+    dgemm(m, n, k, alpha, a.data(), k, b.data(), n, beta, c.data(), n);
+
+    for (int i = 0; i < m * n; i++) {
+        EXPECT_NEAR(c[i], expected_c[i], 1e-12 * k) << "m=" << m << " n=" << n << " k=" << k << " i=" << i;
+    }
+}
+
+TEST(GemmTest, SmallSquare) {
+    expect_gemm_matches(1, 1, 1, 1.0, 0.0);
+    expect_gemm_matches(8, 8, 8, 1.0, 0.0);
+    expect_gemm_matches(16, 16, 16, 1.0, 0.0);
+}
+
+TEST(GemmTest, RaggedEdges) {
+    // sizes that are not multiples of any micro-tile or cache block
+    expect_gemm_matches(7, 13, 5, 1.0, 0.0);
+    expect_gemm_matches(97, 35, 259, 1.0, 0.0);
+    expect_gemm_matches(101, 2051, 3, 1.0, 0.0);
+}
+
+TEST(GemmTest, AlphaBeta) {
+    expect_gemm_matches(33, 17, 29, 2.5, 0.0);
+    expect_gemm_matches(33, 17, 29, 1.0, 1.0);
+    expect_gemm_matches(33, 17, 29, -0.5, 3.0);
+}
+
+TEST(GemmTest, ZeroBetaIgnoresGarbage) {
+    const int n = 10;
+    std::vector<double> a(n * n, 1.0), b(n * n, 2.0), c(n * n, NAN);
+
+    dgemm(n, n, n, 1.0, a.data(), n, b.data(), n, 0.0, c.data(), n);
+
+    for (int i = 0; i < n * n; i++) {
+        EXPECT_EQ(c[i], 2.0 * n);
+    }
+}
+
+TEST(GemmTest, SubMatrixStrides) {
+    // multiply the top-left 5x6 and 6x7 blocks of larger matrices in place
+    const int ld = 11;
+    std::vector<double> a(ld * ld), b(ld * ld), c(ld * ld, -1.0), expected_c(ld * ld, -1.0);
+    fill(a, 4);
+    fill(b, 5);
+
+    reference_gemm(5, 7, 6, 1.0, a.data(), ld, b.data(), ld, 0.0, expected_c.data(), ld);
+    dgemm(5, 7, 6, 1.0, a.data(), ld, b.data(), ld, 0.0, c.data(), ld);
+
+    for (int i = 0; i < ld * ld; i++) {
+        EXPECT_NEAR(c[i], expected_c[i], 1e-13) << "i=" << i;
+    }
+}
+
+TEST(GemmTest, ParallelMatchesSerial) {
+    // odd sizes, so the thread tiles are ragged too
+    const int m = 131, n = 77, k = 45;
+    std::vector<double> a(m * k), b(k * n), c(m * n), expected_c(m * n);
+    fill(a, 6);
+    fill(b, 7);
+    fill(c, 8);
+    expected_c = c;
+
+    dgemm(m, n, k, 1.5, a.data(), k, b.data(), n, 0.5, expected_c.data(), n);
+    dgemm_parallel(m, n, k, 1.5, a.data(), k, b.data(), n, 0.5, c.data(), n);
+
+    // each thread runs the same loop nest, so results are bit-identical
+    for (int i = 0; i < m * n; i++) {
+        EXPECT_EQ(c[i], expected_c[i]) << "i=" << i;
+    }
+}
+
+TEST(SmallMatmulTest, UnrolledMatchesReference) {
+    const int N = 3, M = 4, K = 5;
+    std::vector<double> a(N * M), b(M * K), c(N * K), expected_c(N * K);
+    fill(a, 9);
+    fill(b, 10);
+
+    reference_gemm(N, K, M, 1.0, a.data(), M, b.data(), K, 0.0, expected_c.data(), K);
+    matmul<N, M, K>(a.data(), b.data(), c.data());
+
+    for (int i = 0; i < N * K; i++) {
+        EXPECT_NEAR(c[i], expected_c[i], 1e-14) << "i=" << i;
+    }
+}
+
+TEST(SmallMatmulTest, BatchedMatchesUnrolled) {
+    // batch size not a multiple of the lane block
+    const int S = 6;
+    const size_t count = 150, size = S * S;
+    std::vector<double> a(count * size), b(count * size), c(count * size), expected_c(count * size);
+    const size_t soa_size = batch_storage_size(count, S, S);
+    std::vector<double> a_soa(soa_size), b_soa(soa_size), c_soa(soa_size);
+    fill(a, 11);
+    fill(b, 12);
+
+    for (size_t l = 0; l < count; l++) {
+        matmul<S, S, S>(&a[l * size], &b[l * size], &expected_c[l * size]);
+    }
+
+    interleave_batch(count, S, S, a.data(), a_soa.data());
+    interleave_batch(count, S, S, b.data(), b_soa.data());
+    matmul_batched<S, S, S>(count, a_soa.data(), b_soa.data(), c_soa.data());
+    deinterleave_batch(count, S, S, c_soa.data(), c.data());
+
+    for (size_t i = 0; i < count * size; i++) {
+        EXPECT_NEAR(c[i], expected_c[i], 1e-14) << "i=" << i;
+    }
+}
+
+TEST(StrassenTest, MatchesBlocked) {
+    // even, odd and odd-at-every-level sizes, with a small cutoff so the
+    // recursion goes a few levels deep
+    for (int n: {64, 65, 127, 130}) {
+        std::vector<double> a(n * n), b(n * n), c(n * n, NAN), expected_c(n * n);
+        fill(a, 13);
+        fill(b, 14);
+
+        dgemm(n, n, n, 1.0, a.data(), n, b.data(), n, 0.0, expected_c.data(), n);
+        dgemm_strassen(n, a.data(), n, b.data(), n, c.data(), n, 16);
+
+        for (int i = 0; i < n * n; i++) {
+            EXPECT_NEAR(c[i], expected_c[i], 1e-11) << "n=" << n << " i=" << i;
+        }
+    }
+}
+
+TEST(StrassenTest, WorkspaceSize) {
+    EXPECT_EQ(dgemm_strassen_workspace(100, 100), 0u);
+    EXPECT_EQ(dgemm_strassen_workspace(100, 50), 2u * 50 * 50);
+    EXPECT_EQ(dgemm_strassen_workspace(101, 25), 2u * 50 * 50 + 2u * 25 * 25);
+}
@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "matrix.hpp"
+
+static void fill_indices(Matrix &m) {
+    // (i, j) -> 1000 i + j, to tell the elements apart
+    for (size_t i = 0; i < m.rows(); i++) {
+        for (size_t j = 0; j < m.cols(); j++) {
+            m(i, j) = 1000.0 * i + j;
+        }
+    }
+}
+
+TEST(MatrixTest, AlignedPaddedRows) {
+    for (size_t cols: {1, 7, 8, 9, 100}) {
+        Matrix m(5, cols, 2.5);
+        EXPECT_EQ(m.rows(), 5u);
+        EXPECT_EQ(m.cols(), cols);
+        // whole cache lines per row, every row aligned
+        EXPECT_GE(m.stride(), cols);
+        EXPECT_LT(m.stride(), cols + 8);
+        EXPECT_EQ(m.stride() % 8, 0u);
+        for (size_t i = 0; i < m.rows(); i++) {
+            EXPECT_EQ((uintptr_t)m.row(i) % Matrix::ALIGNMENT, 0u);
+            EXPECT_EQ(m.row(i), m.data() + i * m.stride());
+            for (size_t j = 0; j < cols; j++) {
+                EXPECT_EQ(m(i, j), 2.5);
+            }
+        }
+    }
+}
+
+TEST(MatrixTest, RowStride) {
+    Matrix m(4, 10);
+    fill_indices(m);
+    // the leading dimension is the stride, not the number of columns
+    const double *d = m.data();
+    for (size_t i = 0; i < m.rows(); i++) {
+        for (size_t j = 0; j < m.cols(); j++) {
+            EXPECT_EQ(d[i * m.stride() + j], 1000.0 * i + j);
+        }
+    }
+    MatrixView v = m.view();
+    EXPECT_EQ(v.stride(), m.stride());
+    EXPECT_EQ(v.data(), m.data());
+    EXPECT_EQ(v(3, 9), 3009.0);
+}
+
+TEST(MatrixTest, SubViews) {
+    Matrix m(6, 12);
+    fill_indices(m);
+
+    MatrixView b = m.block(2, 3, 3, 4);
+    EXPECT_EQ(b.rows(), 3u);
+    EXPECT_EQ(b.cols(), 4u);
+    EXPECT_EQ(b.stride(), m.stride());
+    EXPECT_EQ(b(0, 0), 2003.0);
+    EXPECT_EQ(b(2, 3), 4006.0);
+    EXPECT_EQ(b.row(1), m.row(3) + 3);
+
+    // a block of a block, writing through to the matrix
+    MatrixView bb = b.block(1, 1, 2, 2);
+    bb(1, 1) = -1.0;
+    EXPECT_EQ(m(4, 5), -1.0);
+
+    // read-only views, from a mutable one or from a const matrix
+    ConstMatrixView cb = b;
+    EXPECT_EQ(cb(2, 2), -1.0);
+    const Matrix &cm = m;
+    ConstMatrixView cv = cm.block(5, 11, 1, 1);
+    EXPECT_EQ(cv(0, 0), 5011.0);
+    static_assert(std::is_same<decltype(cv(0, 0)), const double &>::value, "read-only view");
+}
+
+TEST(MatrixTest, MoveOnly) {
+    static_assert(!std::is_copy_constructible<Matrix>::value, "no implicit copies");
+    static_assert(!std::is_copy_assignable<Matrix>::value, "no implicit copies");
+    static_assert(std::is_nothrow_move_constructible<Matrix>::value, "cheap moves");
+
+    Matrix a(3, 5);
+    fill_indices(a);
+    const double *storage = a.data();
+
+    Matrix b(std::move(a));
+    EXPECT_EQ(b.data(), storage);
+    EXPECT_EQ(b(2, 4), 2004.0);
+    EXPECT_EQ(a.data(), nullptr);
+    EXPECT_EQ(a.rows(), 0u);
+    EXPECT_EQ(a.cols(), 0u);
+
+    Matrix c;
+    c = std::move(b);
+    EXPECT_EQ(c.data(), storage);
+    EXPECT_EQ(b.data(), nullptr);
+
+    // copies are explicit, into new storage
+    Matrix d = c.copy();
+    EXPECT_NE(d.data(), c.data());
+    EXPECT_EQ(d.stride(), c.stride());
+    EXPECT_EQ(d(1, 3), 1003.0);
+    d(1, 3) = 0.0;
+    EXPECT_EQ(c(1, 3), 1003.0);
+}
@@ -0,0 +1,121 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "moments.hpp"
+
+struct Reference {
+    double mean, m2, m3, m4;
+};
+
+static Reference two_pass(const std::vector<double> &vec) {
+    // textbook definitions in long double
+    long double sum = 0.0;
+    for (double v: vec) {
+        sum += v;
+    }
+    long double mean = sum / vec.size();
+    long double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    for (double v: vec) {
+        long double d = v - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    return {(double)mean, (double)m2, (double)m3, (double)m4};
+}
+
+static std::vector<double> skewed(int n, double offset, unsigned seed) {
+    // exponential, so that M3 and M4 are far from 0
+    std::mt19937_64 gen(seed);
+    std::exponential_distribution<double> dist(1.0);
+    std::vector<double> vec(n);
+    for (int i = 0; i < n; i++) {
+        vec[i] = offset + dist(gen);
+    }
+    return vec;
+}
+
+static void expect_near_reference(const Moments &m, const std::vector<double> &vec) {
+    Reference ref = two_pass(vec);
+    EXPECT_EQ(m.n, (double)vec.size());
+    EXPECT_NEAR(m.mean, ref.mean, 1e-15 * std::fabs(ref.mean) + 1e-15);
+    // blocks merged in another order (threads) move M2 by a few ulps of
+    // the block means, squared over n: 1e-12 is tight with a 1e6 offset
+    EXPECT_NEAR(m.m2, ref.m2, 1e-11 * ref.m2);
+    // the mean is rounded to a double, which moves M3 by about
+    // 3 (mean error) M2 and M4 by 4 (mean error) M3
+    EXPECT_NEAR(m.m3, ref.m3, 1e-9 * std::fabs(ref.m3) + 1e-12 * ref.m2);
+    EXPECT_NEAR(m.m4, ref.m4, 1e-9 * ref.m4);
+}
+
+TEST(MomentsTest, MatchesTwoPass) {
+    for (int n: {1, 2, 3, 100, 2047, 2048, 2049, 100000}) {
+        std::vector<double> vec = skewed(n, 0.0, n);
+        expect_near_reference(StreamingMoments(vec.data(), n), vec);
+    }
+}
+
+TEST(MomentsTest, KnownValues) {
+    const std::vector<double> vec = {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+    Moments m = StreamingMoments(vec.data(), vec.size());
+    EXPECT_DOUBLE_EQ(m.mean, 5.0);
+    EXPECT_DOUBLE_EQ(m.m2, 32.0);
+    EXPECT_DOUBLE_EQ(moments_variance(m), 32.0 / 7.0);
+    EXPECT_DOUBLE_EQ(moments_stdev(m), std::sqrt(32.0 / 7.0));
+}
+
+TEST(MomentsTest, LargeOffset) {
+    // the naive sum of squares loses every digit of the variance here
+    std::vector<double> vec = skewed(100000, 1e9, 7);
+    std::vector<double> shifted(vec.size());
+    for (size_t i = 0; i < vec.size(); i++) {
+        shifted[i] = vec[i] - 1e9; // exact
+    }
+    Moments m = StreamingMoments(vec.data(), vec.size());
+    Moments ref = StreamingMoments(shifted.data(), shifted.size());
+    EXPECT_NEAR(moments_variance(m), moments_variance(ref), 1e-6 * moments_variance(ref));
+    EXPECT_NEAR(moments_skewness(m), moments_skewness(ref), 1e-4);
+    EXPECT_NEAR(moments_excess_kurtosis(m), moments_excess_kurtosis(ref), 1e-3);
+}
+
+TEST(MomentsTest, MergeOfSplits) {
+    std::vector<double> vec = skewed(10000, 3.0, 11);
+    Moments whole = StreamingMoments(vec.data(), vec.size());
+    for (int split: {0, 1, 17, 2048, 5000, 9999, 10000}) {
+        Moments a = StreamingMoments(vec.data(), split);
+        Moments b = StreamingMoments(vec.data() + split, vec.size() - split);
+        moments_merge(a, b);
+        EXPECT_EQ(a.n, whole.n) << split;
+        EXPECT_NEAR(a.mean, whole.mean, 1e-14 * whole.mean) << split;
+        EXPECT_NEAR(a.m2, whole.m2, 1e-12 * whole.m2) << split;
+        EXPECT_NEAR(a.m3, whole.m3, 1e-10 * std::fabs(whole.m3)) << split;
+        EXPECT_NEAR(a.m4, whole.m4, 1e-10 * whole.m4) << split;
+    }
+}
+
+TEST(MomentsTest, Empty) {
+    Moments m = StreamingMoments(nullptr, 0);
+    EXPECT_EQ(m.n, 0.0);
+    EXPECT_EQ(moments_variance(m), 0.0);
+    EXPECT_EQ(moments_skewness(m), 0.0);
+}
+
+TEST(MomentsTest, Parallel) {
+    std::vector<double> vec = skewed(300001, 1e6, 13);
+#if defined(_OPENMP)
+    int threads = omp_get_max_threads();
+    for (int t: {1, 2, 3, 8}) {
+        omp_set_num_threads(t);
+        expect_near_reference(StreamingMoments_parallel(vec.data(), vec.size()), vec);
+    }
+    omp_set_num_threads(threads);
+#else
+    expect_near_reference(StreamingMoments_parallel(vec.data(), vec.size()), vec);
+#endif
+}
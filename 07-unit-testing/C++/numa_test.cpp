@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "numa.hpp"
+
+TEST(NumaTest, Topology) {
+    int nodes = numa_node_count();
+    ASSERT_GE(nodes, 1);
+    size_t cpus = 0;
+    for (int node = 0; node < nodes; node++) {
+        std::vector<int> list = numa_node_cpus(node);
+        EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+        for (int cpu: list) {
+            EXPECT_EQ(numa_node_of_cpu(cpu), node);
+        }
+        cpus += list.size();
+    }
+    EXPECT_GE(cpus, 1u);
+    EXPECT_TRUE(numa_node_cpus(nodes).empty());
+    EXPECT_GE(numa_current_node(), 0);
+    EXPECT_LT(numa_current_node(), nodes);
+}
+
+TEST(NumaTest, StaticSlices) {
+    for (size_t n: {0, 1, 7, 1000, 1001}) {
+        for (int threads: {1, 2, 3, 8}) {
+            size_t expected_begin = 0;
+            for (int t = 0; t < threads; t++) {
+                size_t begin, end;
+                numa_static_slice(n, t, threads, begin, end);
+                EXPECT_EQ(begin, expected_begin);
+                EXPECT_LE(end - begin, n / threads + 1);
+                EXPECT_GE(end - begin, n / threads);
+                expected_begin = end;
+            }
+            EXPECT_EQ(expected_begin, n);
+        }
+    }
+}
+
+TEST(NumaTest, FirstTouch) {
+    const size_t n = 1000003;
+    double *x = numa_alloc_first_touch(n, 2.5);
+    ASSERT_NE(x, nullptr);
+    EXPECT_EQ((uintptr_t)x % 4096, 0u);
+    EXPECT_TRUE(std::all_of(x, x + n, [](double v) { return v == 2.5; }));
+
+    parallel_fill(n, -1.0, x);
+    EXPECT_TRUE(std::all_of(x, x + n, [](double v) { return v == -1.0; }));
+
+    std::vector<size_t> pages = numa_pages_per_node(x, n, 64);
+    if (!pages.empty()) {
+        EXPECT_EQ((int)pages.size(), numa_node_count());
+        size_t sampled = std::accumulate(pages.begin(), pages.end(), (size_t)0);
+        EXPECT_GT(sampled, 0u);
+        EXPECT_LE(sampled, 64u);
+    }
+    numa_free(x);
+}
+
+TEST(NumaTest, AffinityNames) {
+    for (Affinity a: {Affinity::None, Affinity::Compact, Affinity::Scatter}) {
+        Affinity parsed = Affinity::None;
+        EXPECT_TRUE(affinity_from_name(affinity_name(a), parsed));
+        EXPECT_EQ(parsed, a);
+    }
+    Affinity parsed = Affinity::Compact;
+    EXPECT_FALSE(affinity_from_name("spread", parsed));
+    EXPECT_EQ(parsed, Affinity::Compact);
+}
+
+TEST(NumaTest, PinThreads) {
+    for (Affinity a: {Affinity::Compact, Affinity::Scatter}) {
+        int pinned = pin_threads(a);
+        if (pinned == 0) {
+            GTEST_SKIP() << "thread pinning not supported";
+        }
+#if defined(_OPENMP)
+        EXPECT_EQ(pinned, omp_get_max_threads());
+#endif
+        // the pinned team still runs, on CPUs of known nodes
+        int nodes = numa_node_count();
+        #pragma omp parallel
+        {
+            int node = numa_current_node();
+            #pragma omp critical
+            {
+                EXPECT_GE(node, 0);
+                EXPECT_LT(node, nodes);
+            }
+        }
+    }
+    EXPECT_EQ(pin_threads(Affinity::None), 0);
+}
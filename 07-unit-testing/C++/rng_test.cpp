@@ -0,0 +1,159 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "philox.hpp"
+#include "rng.hpp"
+
+TEST(PhiloxTest, KnownAnswers) {
+    // Known-answer vectors of the Random123 distribution (philox4x32, 10 rounds)
+    Philox4x32 r = philox4x32({{0, 0, 0, 0}}, 0, 0);
+    EXPECT_EQ(r.v[0], 0x6627e8d5u);
+    EXPECT_EQ(r.v[1], 0xe169c58du);
+    EXPECT_EQ(r.v[2], 0xbc57ac4cu);
+    EXPECT_EQ(r.v[3], 0x9b00dbd8u);
+
+    r = philox4x32({{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}}, 0xffffffff, 0xffffffff);
+    EXPECT_EQ(r.v[0], 0x408f276du);
+    EXPECT_EQ(r.v[1], 0x41c83b0eu);
+    EXPECT_EQ(r.v[2], 0xa20bc7c6u);
+    EXPECT_EQ(r.v[3], 0x6d5451fdu);
+
+    r = philox4x32({{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}}, 0xa4093822, 0x299f31d0);
+    EXPECT_EQ(r.v[0], 0xd16cfe09u);
+    EXPECT_EQ(r.v[1], 0x94fdccebu);
+    EXPECT_EQ(r.v[2], 0x5001e420u);
+    EXPECT_EQ(r.v[3], 0x24126ea1u);
+}
+
+TEST(RngTest, RangesAreIndependent) {
+    // any sub-range, odd ends included, matches the same slice of the whole
+    const size_t n = 1001;
+    std::vector<double> whole(n);
+    philox_normal(7, 3, 0, n, 0.0, 1.0, whole.data());
+
+    for (size_t first: {0, 1, 2, 499, 998}) {
+        for (size_t count: {1, 2, 3, 100}) {
+            if (first + count > n) {
+                continue;
+            }
+            std::vector<double> part(count);
+            philox_normal(7, 3, first, count, 0.0, 1.0, part.data());
+            for (size_t j = 0; j < count; j++) {
+                EXPECT_EQ(part[j], whole[first + j]) << "first=" << first << " j=" << j;
+            }
+        }
+    }
+}
+
+TEST(RngTest, StreamsDiffer) {
+    std::vector<double> x(16), y(16);
+    philox_normal(1, 0, 0, x.size(), 0.0, 1.0, x.data());
+    philox_normal(1, 1, 0, y.size(), 0.0, 1.0, y.data());
+    for (size_t i = 0; i < x.size(); i++) {
+        EXPECT_NE(x[i], y[i]);
+    }
+}
+
+TEST(RngTest, Moments) {
+    // mean and standard deviation within 5 standard errors
+    const size_t n = 1 << 20;
+    const double mean = 2.0, std = 3.0;
+    std::vector<double> v(n);
+    philox_normal(12345, 0, 0, n, mean, std, v.data());
+
+    double sum = 0.0, sum_sq = 0.0;
+    for (double e: v) {
+        sum += e;
+        sum_sq += (e - mean) * (e - mean);
+    }
+    EXPECT_NEAR(sum / n, mean, 5 * std / std::sqrt(n));
+    EXPECT_NEAR(std::sqrt(sum_sq / n), std, 5 * std / std::sqrt(2.0 * n));
+}
+
+TEST(RngTest, AllKernelsMatch) {
+    // every ISA gives bit-identical values
+    const size_t pairs = 1000;
+    std::vector<double> expected(2 * pairs);
+    rng_kernel(Isa::Scalar)(99, 5, 123456789, pairs, 1.0, 2.0, expected.data());
+
+    for (Isa isa: {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        normal_pairs_kernel_t kernel = rng_kernel(isa);
+        if (kernel == nullptr) {
+            continue;
+        }
+        std::vector<double> out(2 * pairs);
+        kernel(99, 5, 123456789, pairs, 1.0, 2.0, out.data());
+        for (size_t i = 0; i < out.size(); i++) {
+            EXPECT_EQ(out[i], expected[i]) << isa_name(isa) << " i=" << i;
+        }
+    }
+}
+
+TEST(RngTest, MatchesLibmBoxMuller) {
+    // the in-house log and sin/cos against libm
+    const size_t n = 20000;
+    std::vector<double> out(n);
+    philox_normal(2024, 0, 0, n, 0.0, 1.0, out.data());
+
+    for (size_t b = 0; b < n / 2; b++) {
+        Philox4x32 r = philox4x32({{uint32_t(b), 0, 0, 0}}, 2024, 0);
+        double radius = std::sqrt(-2.0 * std::log(philox_uniform(r.v[0], r.v[1])));
+        double angle = 2.0 * M_PI * philox_uniform(r.v[2], r.v[3]);
+        EXPECT_NEAR(out[2 * b], radius * std::cos(angle), 1e-14 * (1 + radius)) << "b=" << b;
+        EXPECT_NEAR(out[2 * b + 1], radius * std::sin(angle), 1e-14 * (1 + radius)) << "b=" << b;
+    }
+}
+
+TEST(RngTest, FillNormalAdvances) {
+    std::vector<double> whole(101), parts(101);
+    RngStream one = {8, 2, 0}, two = {8, 2, 0};
+    fill_normal(whole.data(), whole.size(), 0.0, 1.0, one);
+    fill_normal(parts.data(), 37, 0.0, 1.0, two);
+    fill_normal(parts.data() + 37, 64, 0.0, 1.0, two);
+    EXPECT_EQ(one.position, 101u);
+    EXPECT_EQ(two.position, 101u);
+    EXPECT_EQ(whole, parts);
+}
+
+// mean, variance, skewness and excess kurtosis of standardized samples
+static std::vector<double> moments(const std::vector<double> &v, double mean, double std) {
+    double m[4] = {0, 0, 0, 0};
+    for (double e: v) {
+        double z = (e - mean) / std;
+        m[0] += z;
+        m[1] += z * z;
+        m[2] += z * z * z;
+        m[3] += z * z * z * z;
+    }
+    double n = v.size();
+    return {m[0] / n, m[1] / n, m[2] / n, m[3] / n - 3.0};
+}
+
+TEST(RngTest, MomentsMatchStdNormalDistribution) {
+    // both generators within 5 standard errors of the normal moments
+    // (standard errors of the estimators: 1, sqrt 2, sqrt 6, sqrt 96 over sqrt n)
+    const size_t n = 1 << 20;
+    const double mean = -1.0, std = 0.5;
+    const double se[4] = {1.0, std::sqrt(2.0), std::sqrt(6.0), std::sqrt(96.0)};
+
+    std::vector<double> ours(n), reference(n);
+    RngStream stream = {31337, 0, 0};
+    fill_normal(ours.data(), n, mean, std, stream);
+    std::mt19937_64 engine(31337);
+    std::normal_distribution<double> d(mean, std);
+    for (double &e: reference) {
+        e = d(engine);
+    }
+
+    std::vector<double> m_ours = moments(ours, mean, std), m_reference = moments(reference, mean, std);
+    const double expected[4] = {0.0, 1.0, 0.0, 0.0};
+    for (int k = 0; k < 4; k++) {
+        double tolerance = 5 * se[k] / std::sqrt(double(n));
+        EXPECT_NEAR(m_ours[k], expected[k], tolerance) << "moment " << k + 1;
+        EXPECT_NEAR(m_reference[k], expected[k], tolerance) << "moment " << k + 1 << " (std::normal_distribution)";
+    }
+}
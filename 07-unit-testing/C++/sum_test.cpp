@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "sum.hpp"
+
+static const Isa ISAS[] = {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512};
+
+static double kernel_sum(kbn_kernel_t kernel, const std::vector<double> &vec) {
+    CompensatedSum s = kernel(vec.data(), vec.size());
+    return s.sum + s.c;
+}
+
+TEST(SumTest, IllConditioned) {
+    // naive summation gives 0 or -0.5 here
+    const std::vector<double> vec = {1.0, 1.0e16, -1.0e16, -0.5};
+    EXPECT_EQ(KahanBabushkaNeumaierSum(vec.data(), vec.size()), 0.5);
+
+    for (Isa isa: ISAS) {
+        kbn_kernel_t kernel = kbn_kernel(isa);
+        if (kernel == nullptr) {
+            continue;
+        }
+        EXPECT_EQ(kernel_sum(kernel, vec), 0.5) << isa_name(isa);
+    }
+}
+
+TEST(SumTest, ExactForAllLengths) {
+    // huge terms cancelling out around small ones: every lane sees
+    // both, the exact sum is the number of ones, which must come out
+    // for all lengths, whatever is left for the remainder loop
+    for (int n = 0; n <= 67; n++) {
+        std::vector<double> vec(n);
+        double expected = 0.0;
+        for (int i = 0; i < n; i++) {
+            switch (i % 3) {
+            case 0:
+                vec[i] = 1.0;
+                expected += 1.0;
+                break;
+            case 1:
+                vec[i] = 0x1p60;
+                break;
+            default:
+                vec[i] = -0x1p60;
+            }
+        }
+        if (n % 3 == 2) {
+            // unmatched big term
+            expected += 0x1p60;
+        }
+
+        for (Isa isa: ISAS) {
+            kbn_kernel_t kernel = kbn_kernel(isa);
+            if (kernel == nullptr) {
+                continue;
+            }
+            EXPECT_EQ(kernel_sum(kernel, vec), expected) << isa_name(isa) << " n=" << n;
+        }
+        EXPECT_EQ(KahanBabushkaNeumaierSum(vec.data(), n), expected) << "n=" << n;
+    }
+}
+
+TEST(SumTest, MatchesScalar) {
+    // random data over many decades: the SIMD kernels add in a different
+    // order, so they agree with the scalar one up to the KBN error bound
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-20, 20);
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    for (int n: {1, 7, 31, 64, 1000, 100003}) {
+        std::vector<double> vec(n);
+        double sum_abs = 0.0;
+        for (int i = 0; i < n; i++) {
+            vec[i] = std::ldexp(mantissa(gen), exponent(gen));
+            sum_abs += std::fabs(vec[i]);
+        }
+        double expected = kernel_sum(KahanBabushkaNeumaierSum_scalar, vec);
+        double tolerance = 2 * eps * std::fabs(expected) + n * eps * eps * sum_abs;
+
+        for (Isa isa: ISAS) {
+            kbn_kernel_t kernel = kbn_kernel(isa);
+            if (kernel == nullptr) {
+                continue;
+            }
+            EXPECT_NEAR(kernel_sum(kernel, vec), expected, tolerance) << isa_name(isa) << " n=" << n;
+        }
+    }
+}
+
+TEST(SumTest, MergePartials) {
+    // partial sums of two halves merge into the sum of the whole
+    const std::vector<double> vec = {1.0e16, 1.0, -1.0e16, 3.0, 1.0e-3, 2.0e16, -2.0e16, 0.5};
+    CompensatedSum a = KahanBabushkaNeumaierSum_partial(vec.data(), 3);
+    CompensatedSum b = KahanBabushkaNeumaierSum_partial(vec.data() + 3, vec.size() - 3);
+    CompensatedSum ab = compensated_merge(a, b);
+    EXPECT_EQ(ab.sum + ab.c, 4.5 + 1.0e-3);
+
+    CompensatedSum empty = KahanBabushkaNeumaierSum_partial(vec.data(), 0);
+    EXPECT_EQ(empty.sum, 0.0);
+    EXPECT_EQ(empty.c, 0.0);
+}
+
+TEST(SumTest, MergePairwise) {
+    // block sums that cancel inside each block, for every tree shape
+    CompensatedSum none = compensated_merge_pairwise(nullptr, 0);
+    EXPECT_EQ(none.sum, 0.0);
+    EXPECT_EQ(none.c, 0.0);
+    for (int blocks = 1; blocks <= 9; blocks++) {
+        std::vector<CompensatedSum> partial;
+        double expected = 0.0;
+        for (int b = 0; b < blocks; b++) {
+            const double block[3] = {1.0e17, b + 0.5, -1.0e17};
+            partial.push_back(KahanBabushkaNeumaierSum_partial(block, 3));
+            expected += b + 0.5;
+        }
+        CompensatedSum s = compensated_merge_pairwise(partial.data(), blocks);
+        EXPECT_EQ(s.sum + s.c, expected) << blocks << " blocks";
+    }
+}
+
+TEST(SumTest, ParallelIsReproducible) {
+    // same bits for every thread count, and as accurate as the serial sum
+    const int n = 40 * KBN_PARALLEL_BLOCK + 123;
+    std::mt19937_64 gen(7);
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-30, 30);
+    std::vector<double> vec(n);
+    for (int i = 0; i < n; i++) {
+        vec[i] = std::ldexp(mantissa(gen), exponent(gen));
+    }
+
+    double serial = KahanBabushkaNeumaierSum(vec.data(), n);
+    double expected = KahanBabushkaNeumaierSum_parallel(vec.data(), n);
+    EXPECT_NEAR(expected, serial, 4 * std::numeric_limits<double>::epsilon() * std::fabs(serial));
+
+#if defined(_OPENMP)
+    const int saved = omp_get_max_threads();
+    for (int threads: {1, 2, 3, 5, 8}) {
+        omp_set_num_threads(threads);
+        EXPECT_EQ(KahanBabushkaNeumaierSum_parallel(vec.data(), n), expected) << threads << " threads";
+    }
+    omp_set_num_threads(saved);
+#endif
+}
+
+TEST(SumTest, OpenMPReduction) {
+    // the compensated_merge reduction keeps the cancellation right
+    const int n = 3000;
+    std::vector<double> vec(n);
+    for (int i = 0; i < n; i++) {
+        vec[i] = (i % 3 == 0) ? 1.0 : ((i % 3 == 1) ? 1.0e17 : -1.0e17);
+    }
+    CompensatedSum total = {0.0, 0.0};
+    #pragma omp parallel for reduction(compensated_merge: total)
+    for (int i = 0; i < n; i++) {
+        compensated_add(total, vec[i]);
+    }
+    EXPECT_EQ(total.sum + total.c, 1000.0);
+}
+
+static std::vector<double> wide_random(int n, unsigned seed) {
+    // magnitudes over 60 decades, both signs, so that the order matters
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-100, 100);
+    std::vector<double> vec(n);
+    for (int i = 0; i < n; i++) {
+        vec[i] = std::ldexp(mantissa(gen), exponent(gen));
+    }
+    return vec;
+}
+
+TEST(ReproducibleSumTest, OrderIndependent) {
+    std::vector<double> vec = wide_random(100003, 11);
+    const double expected = ReproducibleSum(vec.data(), vec.size());
+
+    std::mt19937_64 gen(3);
+    for (int trial = 0; trial < 3; trial++) {
+        std::shuffle(vec.begin(), vec.end(), gen);
+        EXPECT_EQ(ReproducibleSum(vec.data(), vec.size()), expected);
+    }
+    std::reverse(vec.begin(), vec.end());
+    EXPECT_EQ(ReproducibleSum(vec.data(), vec.size()), expected);
+}
+
+TEST(ReproducibleSumTest, SplitsAndMerges) {
+    // any split in pieces, merged in any order, gives the same bits
+    const std::vector<double> vec = wide_random(50000, 5);
+    const double expected = ReproducibleSum(vec.data(), vec.size());
+
+    for (int pieces: {2, 3, 7, 64, 1000}) {
+        std::vector<BinnedSum> partial(pieces);
+        for (int p = 0; p < pieces; p++) {
+            int begin = (long)vec.size() * p / pieces, end = (long)vec.size() * (p + 1) / pieces;
+            binned_sum_clear(partial[p]);
+            binned_sum_add(partial[p], vec.data() + begin, end - begin);
+        }
+        BinnedSum forward, backward;
+        binned_sum_clear(forward);
+        binned_sum_clear(backward);
+        for (int p = 0; p < pieces; p++) {
+            binned_sum_merge(forward, partial[p]);
+            binned_sum_merge(backward, partial[pieces - 1 - p]);
+        }
+        EXPECT_EQ(binned_sum_value(forward), expected) << pieces << " pieces";
+        EXPECT_EQ(binned_sum_value(backward), expected) << pieces << " pieces";
+    }
+}
+
+TEST(ReproducibleSumTest, ParallelMatchesSerial) {
+    const std::vector<double> vec = wide_random(300007, 17);
+    const double expected = ReproducibleSum(vec.data(), vec.size());
+    EXPECT_EQ(ReproducibleSum_parallel(vec.data(), vec.size()), expected);
+
+#if defined(_OPENMP)
+    const int saved = omp_get_max_threads();
+    for (int threads: {1, 2, 3, 8}) {
+        omp_set_num_threads(threads);
+        EXPECT_EQ(ReproducibleSum_parallel(vec.data(), vec.size()), expected) << threads << " threads";
+    }
+    omp_set_num_threads(saved);
+#endif
+}
+
+TEST(ReproducibleSumTest, Accurate) {
+    const std::vector<double> cancel = {1.0, 1.0e16, -1.0e16, -0.5};
+    EXPECT_EQ(ReproducibleSum(cancel.data(), cancel.size()), 0.5);
+
+    // exact on integers, even when the big terms are far apart
+    std::vector<double> vec;
+    for (int i = 0; i < 5000; i++) {
+        vec.push_back(0x1p70);
+        vec.push_back(3.0);
+        vec.push_back(-0x1p70);
+    }
+    EXPECT_EQ(ReproducibleSum(vec.data(), vec.size()), 15000.0);
+
+    // tiny values, down to the subnormals
+    const std::vector<double> tiny = {0x1p-1074, 0x1p-1060, -0x1p-1074, 0x1p-1022};
+    EXPECT_EQ(ReproducibleSum(tiny.data(), tiny.size()), 0x1p-1060 + 0x1p-1022);
+
+    // close to KBN on random data
+    const std::vector<double> wide = wide_random(10000, 23);
+    double kbn = KahanBabushkaNeumaierSum(wide.data(), wide.size());
+    EXPECT_NEAR(ReproducibleSum(wide.data(), wide.size()), kbn,
+                4 * std::numeric_limits<double>::epsilon() * std::fabs(kbn));
+}
+
+TEST(ReproducibleSumTest, SpecialValues) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> vec = wide_random(1000, 1);
+    EXPECT_TRUE(std::isfinite(ReproducibleSum(vec.data(), vec.size())));
+
+    vec[500] = inf;
+    EXPECT_EQ(ReproducibleSum(vec.data(), vec.size()), inf);
+    vec[10] = -inf;
+    EXPECT_TRUE(std::isnan(ReproducibleSum(vec.data(), vec.size())));
+
+    std::vector<double> empty;
+    EXPECT_EQ(ReproducibleSum(empty.data(), 0), 0.0);
+}
+
+TEST(ExactSumTest, Cancellation) {
+    const std::vector<double> vec = {1.0, 1.0e100, 1.0, -1.0e100};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), 2.0);
+
+    // a tie broken by a tiny term, which KBN loses
+    const std::vector<double> tie = {1.0, 1.0e-100, 1.0e16};
+    EXPECT_EQ(ExactSum(tie.data(), tie.size()), 1.0e16 + 2.0);
+
+    // x and -x in any order
+    std::vector<double> pm = wide_random(10000, 31);
+    for (int i = 0; i < 10000; i++) {
+        pm.push_back(-pm[i]);
+    }
+    std::shuffle(pm.begin(), pm.end(), std::mt19937_64(4));
+    EXPECT_EQ(ExactSum(pm.data(), pm.size()), 0.0);
+}
+
+TEST(ExactSumTest, CorrectlyRounded) {
+    // a tie rounds to even, unless something below breaks it
+    std::vector<double> vec = {1.0, 0x1p-53};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), 1.0);
+    vec.push_back(0x1p-1074);
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), 1.0 + 0x1p-52);
+    vec.back() = -0x1p-1074;
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), 1.0);
+    vec = {1.0 + 0x1p-52, 0x1p-53};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), 1.0 + 0x1p-51);
+    vec = {-1.0, -0x1p-53, -0x1p-1074};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), -1.0 - 0x1p-52);
+
+    // random data: the error of the result is at most half an ulp,
+    // and the result agrees with KBN up to KBN's own error bound
+    const std::vector<double> wide = wide_random(100000, 37);
+    double sum = ExactSum(wide.data(), wide.size());
+    std::vector<double> residual = wide;
+    residual.push_back(-sum);
+    double half_ulp = std::ldexp(std::nextafter(std::fabs(sum), INFINITY) - std::fabs(sum), -1);
+    EXPECT_LE(std::fabs(ExactSum(residual.data(), residual.size())), half_ulp);
+    double kbn = KahanBabushkaNeumaierSum(wide.data(), wide.size());
+    EXPECT_NEAR(sum, kbn, 4 * std::numeric_limits<double>::epsilon() * std::fabs(sum));
+}
+
+TEST(ExactSumTest, Range) {
+    const double max = std::numeric_limits<double>::max();
+    const double inf = std::numeric_limits<double>::infinity();
+
+    // subnormals are exact
+    std::vector<double> vec = {0x1p-1074, 0x1p-1074, 0x1p-1022, -0x1p-1074};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), 0x1p-1022 + 0x1p-1074);
+
+    // no overflow in the middle of the sum
+    vec = {max, max, -max};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), max);
+    vec = {max, max};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), inf);
+    vec = {-max, -max};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), -inf);
+
+    vec = {1.0, inf};
+    EXPECT_EQ(ExactSum(vec.data(), vec.size()), inf);
+    vec.push_back(-inf);
+    EXPECT_TRUE(std::isnan(ExactSum(vec.data(), vec.size())));
+}
+
+TEST(ExactSumTest, MergeAndParallel) {
+    const std::vector<double> vec = wide_random(300007, 41);
+    const double expected = ExactSum(vec.data(), vec.size());
+
+    SuperAccumulator a, b;
+    superacc_clear(a);
+    superacc_clear(b);
+    superacc_add(a, vec.data(), 1234);
+    superacc_add(b, vec.data() + 1234, vec.size() - 1234);
+    superacc_merge(b, a);
+    EXPECT_EQ(superacc_value(b), expected);
+
+    EXPECT_EQ(ExactSum_parallel(vec.data(), vec.size()), expected);
+#if defined(_OPENMP)
+    const int saved = omp_get_max_threads();
+    for (int threads: {2, 3}) {
+        omp_set_num_threads(threads);
+        EXPECT_EQ(ExactSum_parallel(vec.data(), vec.size()), expected) << threads << " threads";
+    }
+    omp_set_num_threads(saved);
+#endif
+}
+
+TEST(SumMethodTest, Names) {
+    for (SumMethod method: {SumMethod::KBN, SumMethod::Reproducible, SumMethod::Exact}) {
+        SumMethod parsed;
+        ASSERT_TRUE(sum_method_from_name(sum_method_name(method), parsed));
+        EXPECT_EQ(parsed, method);
+    }
+    SumMethod parsed;
+    EXPECT_FALSE(sum_method_from_name("pairwise", parsed));
+
+    const std::vector<double> vec = {1.0, 1.0e16, -1.0e16, -0.5};
+    EXPECT_EQ(sum_with(SumMethod::Exact, vec.data(), vec.size()), 0.5);
+    EXPECT_EQ(sum_with_parallel(SumMethod::Reproducible, vec.data(), vec.size()), 0.5);
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tuning.hpp"
+
+static const ChunkedKernel KERNELS[] = {ChunkedKernel::Daxpy, ChunkedKernel::Sum, ChunkedKernel::DaxpySum};
+
+TEST(TuningTest, CacheSizes) {
+    const CacheSizes &c = cache_sizes();
+    EXPECT_GT(c.l1d, 0u);
+    if (c.l2 > 0) {
+        EXPECT_GE(c.l2, c.l1d);
+    }
+    if (c.l3 > 0) {
+        EXPECT_GE(c.l3, c.l2);
+    }
+}
+
+TEST(TuningTest, Candidates) {
+    for (ChunkedKernel kernel: KERNELS) {
+        for (int n: {1, 100, 5000, 1 << 20, 100000007}) {
+            std::vector<int> candidates = chunk_size_candidates(kernel, n);
+            ASSERT_FALSE(candidates.empty());
+            EXPECT_EQ(candidates.back(), n);
+            EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+            for (size_t i = 0; i + 1 < candidates.size(); i++) {
+                EXPECT_LT(candidates[i], candidates[i + 1]);
+                EXPECT_EQ(candidates[i] % 64, 0);
+            }
+        }
+    }
+}
+
+TEST(TuningTest, TunedInRange) {
+    setenv("SC4PS_TUNING_CACHE", "", 1); // no file
+    for (ChunkedKernel kernel: KERNELS) {
+        for (int n: {1, 10, 1000, 1 << 16, 100000}) {
+            for (bool parallel: {false, true}) {
+                int chunk = tuned_chunk_size(kernel, n, parallel);
+                EXPECT_GE(chunk, 1);
+                EXPECT_LE(chunk, n);
+            }
+        }
+    }
+    // short vectors are not split
+    EXPECT_EQ(tuned_chunk_size(ChunkedKernel::Daxpy, 1000), 1000);
+}
+
+TEST(TuningTest, Persisted) {
+    std::string path = testing::TempDir() + "sc4ps_tuning_test.conf";
+    std::remove(path.c_str());
+    setenv("SC4PS_TUNING_CACHE", path.c_str(), 1);
+
+    const int n = (1 << 15) + 3;
+    int chunk = tuned_chunk_size(ChunkedKernel::DaxpySum, n);
+    // the second call is served from the cache
+    EXPECT_EQ(tuned_chunk_size(ChunkedKernel::DaxpySum, n), chunk);
+
+    std::ifstream in(path);
+    ASSERT_TRUE(in.good());
+    std::stringstream contents;
+    contents << in.rdbuf();
+    const CacheSizes &c = cache_sizes();
+    std::string signature = "cache = " + std::to_string(c.l1d) + "," + std::to_string(c.l2) + "," + std::to_string(c.l3);
+    EXPECT_NE(contents.str().find(signature), std::string::npos);
+    EXPECT_NE(contents.str().find("daxpy_sum.2^15 = "), std::string::npos);
+    std::remove(path.c_str());
+}
+
+static std::string write_tuning_cache(const std::string &name, int chunk) {
+    std::string path = testing::TempDir() + name;
+    const CacheSizes &c = cache_sizes();
+    std::ofstream out(path);
+    out << "cache = " << c.l1d << "," << c.l2 << "," << c.l3 << std::endl;
+    out << "daxpy.2^14 = " << chunk << std::endl;
+    return path;
+}
+
+TEST(TuningTest, ReloadedWhenThePathChanges) {
+    // values from the file in use, not from the one read first
+    const int n = (1 << 14) + 5;
+    std::string first = write_tuning_cache("sc4ps_tuning_first.conf", 1024);
+    std::string second = write_tuning_cache("sc4ps_tuning_second.conf", 2048);
+
+    setenv("SC4PS_TUNING_CACHE", first.c_str(), 1);
+    EXPECT_EQ(tuned_chunk_size(ChunkedKernel::Daxpy, n), 1024);
+    setenv("SC4PS_TUNING_CACHE", second.c_str(), 1);
+    EXPECT_EQ(tuned_chunk_size(ChunkedKernel::Daxpy, n), 2048);
+    setenv("SC4PS_TUNING_CACHE", first.c_str(), 1);
+    EXPECT_EQ(tuned_chunk_size(ChunkedKernel::Daxpy, n), 1024);
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+}
@@ -0,0 +1,109 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "crc32c.hpp"
+#include "vector_io.hpp"
+
+static std::vector<double> ramp(size_t n, double scale) {
+    std::vector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = scale * i + 0.25;
+    return v;
+}
+
+static std::vector<double> read_back(size_t n, const std::string &fname) {
+    std::vector<double> v(n);
+    double *p = v.data();
+    read_vector_binary(n, fname, p, true);
+    return v;
+}
+
+TEST(VectorIOTest, AsyncRoundTrip) {
+    // Not a multiple of the default segment, so the last one is short
+    const size_t N = 3 * (1 << 20) + 123;
+    std::string fname = testing::TempDir() + "sc4ps_vector_io_async.dat";
+    std::vector<double> x = ramp(N, 0.5);
+
+    dump_vector_binary_async(N, fname, x.data());
+    VectorFileHeader header = read_vector_header(fname);
+    EXPECT_EQ(header.length, N);
+    EXPECT_EQ(header.checksum_type, uint32_t(CHECKSUM_CRC32C));
+    EXPECT_EQ(header.checksum, crc32c(0, x.data(), N * sizeof(double)));
+    EXPECT_EQ(read_back(N, fname), x);
+
+    std::vector<double> y(N);
+    read_vector_binary_async(N, fname, y.data(), true);
+    EXPECT_EQ(y, x);
+    std::remove(fname.c_str());
+}
+
+TEST(VectorIOTest, ThreadPoolPipeline) {
+    // Small segments and a shallow queue, so that reads, computation
+    // and writes of different segments are in flight together
+    const size_t N = 10007, SEGMENT = 256;
+    std::string fname_x = testing::TempDir() + "sc4ps_vector_io_x.dat";
+    std::string fname_y = testing::TempDir() + "sc4ps_vector_io_y.dat";
+    std::string fname_d = testing::TempDir() + "sc4ps_vector_io_d.dat";
+    std::vector<double> x0 = ramp(N, 1.0), y0 = ramp(N, -3.0);
+    dump_vector_binary(N, fname_x, x0.data());
+    dump_vector_binary(N, fname_y, y0.data());
+
+    std::vector<double> x(N), y(N);
+    AsyncVectorIO io(N, SEGMENT, 3, false);
+    EXPECT_STREQ(io.backend(), "thread pool");
+    io.read(fname_x, x.data(), true);
+    io.read(fname_y, y.data(), true);
+    int file_d = io.dump(fname_d);
+    size_t expected = 0, offset, count;
+    while (io.wait_segment(offset, count)) {
+        EXPECT_EQ(offset, expected);
+        EXPECT_EQ(count, std::min(SEGMENT, N - offset));
+        for (size_t i = offset; i < offset + count; i++) {
+            ASSERT_EQ(x[i], x0[i]);
+            ASSERT_EQ(y[i], y0[i]);
+            y[i] += 2.0 * x[i];
+        }
+        io.dump_segment(file_d, offset, count, y.data());
+        expected += count;
+    }
+    EXPECT_EQ(expected, N);
+    io.finish();
+
+    for (size_t i = 0; i < N; i++)
+        y0[i] += 2.0 * x0[i];
+    EXPECT_EQ(read_back(N, fname_d), y0);
+    EXPECT_EQ(read_vector_header(fname_d).checksum, crc32c(0, y0.data(), N * sizeof(double)));
+    for (const std::string &fname: {fname_x, fname_y, fname_d})
+        std::remove(fname.c_str());
+}
+
+TEST(VectorIOTest, ThreadPoolChecksumMismatch) {
+    const size_t N = 5000;
+    std::string fname = testing::TempDir() + "sc4ps_vector_io_corrupt.dat";
+    std::vector<double> x = ramp(N, 2.0);
+    dump_vector_binary(N, fname, x.data());
+    {
+        // Flip one payload byte behind the header's back
+        std::fstream file(fname, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(VECTOR_FILE_ALIGNMENT + 1000);
+        file.put('\x7f');
+    }
+
+    std::vector<double> y(N);
+    EXPECT_EXIT({
+        AsyncVectorIO io(N, 512, 2, false);
+        io.read(fname, y.data(), true);
+        io.finish();
+    }, testing::ExitedWithCode(EXIT_FAILURE), "checksum mismatch");
+
+    // Without verify the data is taken as it is
+    AsyncVectorIO io(N, 512, 2, false);
+    io.read(fname, y.data());
+    io.finish();
+    EXPECT_NE(y, x);
+    std::remove(fname.c_str());
+}
@@ -0,0 +1,113 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "daxpy.hpp"
+#include "vector.hpp"
+
+static Vector<double> ramp(size_t n, double start, double step) {
+    Vector<double> v(n);
+    for (size_t i = 0; i < n; i++) {
+        v[i] = start + step * i;
+    }
+    return v;
+}
+
+TEST(VectorTest, ExpressionMatchesLoop) {
+    const double a = 1.5, b = -0.25;
+    // long enough for the threads, with a remainder
+    for (size_t n: {0, 1, 7, 1000, 100003}) {
+        Vector<double> x = ramp(n, 0.1, 0.01), y = ramp(n, -3.0, 0.5), z = ramp(n, 2.0, -0.125);
+        Vector<double> d(n);
+        d = a*x + b*y - z;
+        for (size_t i = 0; i < n; i++) {
+            EXPECT_DOUBLE_EQ(d[i], a * x[i] + b * y[i] - z[i]) << "n = " << n << " i = " << i;
+        }
+    }
+}
+
+TEST(VectorTest, InPlaceIsDaxpy) {
+    const size_t n = 1003;
+    const double a = 3.0;
+    Vector<double> x = ramp(n, 0.1, 0.1), y = ramp(n, 7.1, -0.01);
+    std::vector<double> expected(y.data(), y.data() + n);
+    daxpy(n, a, x.data(), expected.data());
+
+    y += a*x;
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(y[i], expected[i]);
+    }
+
+    y -= a*x;
+    y *= 2.0;
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(y[i], 2.0 * (expected[i] - a * x[i]));
+    }
+}
+
+TEST(VectorTest, Reductions) {
+    const size_t n = 5000;
+    Vector<double> x = ramp(n, -1.0, 0.001), w(n, 2.0);
+
+    double sum_x = 0.0, sum_abs = 0.0, sum_sq = 0.0, max_abs = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum_x += x[i];
+        sum_abs += std::fabs(x[i]);
+        sum_sq += x[i] * x[i];
+        max_abs = std::max(max_abs, std::fabs(x[i]));
+    }
+    EXPECT_NEAR(sum(x), sum_x, 1e-9);
+    EXPECT_NEAR(dot(x, w), 2.0 * sum_x, 1e-9);
+    EXPECT_NEAR(norm1(x), sum_abs, 1e-9);
+    EXPECT_NEAR(norm2(x), std::sqrt(sum_sq), 1e-9);
+    EXPECT_EQ(norm_inf(x), max_abs);
+    // expressions reduce without being stored
+    EXPECT_NEAR(sum(x - x), 0.0, 0.0);
+    EXPECT_NEAR(dot(2.0*x, w - w), 0.0, 0.0);
+}
+
+TEST(VectorTest, DotIsCompensated) {
+    // naive accumulation gives 0 or -0.5
+    Vector<double> x(4), w(4, 1.0);
+    x[0] = 1.0;
+    x[1] = 1.0e16;
+    x[2] = -1.0e16;
+    x[3] = -0.5;
+    EXPECT_EQ(dot(x, w), 0.5);
+}
+
+TEST(VectorTest, AssignAndDot) {
+    const size_t n = 70001;
+    const double a = 2.0, b = 0.5;
+    Vector<double> x = ramp(n, 0.0, 1e-3), y = ramp(n, 1.0, -1e-4), z = ramp(n, 0.3, 0.0), w = ramp(n, 1.0, 1e-5);
+
+    Vector<double> d1(n), d2(n);
+    d1 = a*x + b*y - z;
+    double expected = dot(d1, w);
+    double s = assign_and_dot(d2, a*x + b*y - z, w);
+
+    EXPECT_NEAR(s, expected, 1e-12 * std::fabs(expected));
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(d2[i], d1[i]);
+    }
+}
+
+TEST(VectorTest, Float) {
+    const size_t n = 100;
+    Vector<float> x(n, 0.1f), y(n, 7.1f);
+    Vector<float> d = 3.0f*x + y;
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_FLOAT_EQ(d[i], 3.0f * 0.1f + 7.1f);
+    }
+    // products and sums in double
+    EXPECT_DOUBLE_EQ(dot(x, y), n * (double)0.1f * (double)7.1f);
+}
+
+TEST(VectorTest, SizesMustMatch) {
+    Vector<double> x(10), y(11), d(10);
+    EXPECT_THROW(x + y, std::invalid_argument);
+    EXPECT_THROW(d = 2.0*y, std::invalid_argument);
+    EXPECT_THROW(dot(x, y), std::invalid_argument);
+}
@@ -1,28 +1,15 @@
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <iostream>
 #include <chrono>
+#include <string>
+#include <vector>
 
-double KahanBabushkaNeumaierSum(const double *vec, int n) {
-    /*
-    Kahan-Babushka-Neumaier summation algorithm
-    This algorithm is a modification of the Kahan summation algorithm that uses two variables
-    to keep track of the compensation for lost low-order bits.
-    */
-
-    double sum = 0.0, c = 0.0;
-
-    for (int i = 0; i < n; i++) {
-        double t = sum + vec[i];
-        if (abs(sum) >= abs(vec[i])) {
-            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
-        } else {
-            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
-        }
-        sum = t;
-    }
-    return sum + c;
-}
+#include "daxpy.hpp"
+#include "daxpy_sum.hpp"
+#include "sum.hpp"
+#include "tuning.hpp"
 
 void daxpy_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
 
@@ -30,21 +17,18 @@ void daxpy_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
         return;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Daxpy, n);
     }
-    assert(chunk_size <= n);
+    chunk_size = std::min(chunk_size, n);
 
     int remainder = n % chunk_size;
     // Process eventual smaller chunk first
-    for (int i = 0; i < remainder; i++) {
-        y[i] += a * x[i];
-    }
+    daxpy(remainder, a, x, y);
 
     for (int chunk_start = remainder; chunk_start < n; chunk_start += chunk_size) {
-        for (int i = 0; i < chunk_size; i++) {
-            y[chunk_start + i] += a * x[chunk_start + i];
-        }
+        daxpy(chunk_size, a, x + chunk_start, y + chunk_start);
     }
 }
 
@@ -54,30 +38,58 @@ double sum_chunked(int n, double *x, int chunk_size=0) {
         return 0.0;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Sum, n);
     }
-    assert(chunk_size <= n);
+    chunk_size = std::min(chunk_size, n);
 
     int n_chunks = n / chunk_size;
     int remainder = n % chunk_size;
-    double* partial_sums = new double[n_chunks + (remainder > 0 ? 1 : 0)];
+
+    // All chunks go to one binned accumulator, whose result does not
+    // depend on how the vector is cut: same bits for any chunk size
+    BinnedSum sum;
+    binned_sum_clear(sum);
 
     // Process eventual smaller chunk first
-    // but put it in last element of partial_sums array
-    double sum = 0.0;
-    for (int i = 0; i < remainder; i++) {
-        sum += x[i];
-    }
-    partial_sums[n_chunks - (remainder > 0 ? 0 : 1)] = sum;
+    binned_sum_add(sum, x, remainder);
 
     // Now process all full chunks;
     for (int chunk = 0, start_index = remainder; chunk < n_chunks; chunk++, start_index += chunk_size) {
-        partial_sums[chunk] = KahanBabushkaNeumaierSum(x + start_index, chunk_size);
+        binned_sum_add(sum, x + start_index, chunk_size);
     }
 
-    // Now sum up all partial sums
-    return KahanBabushkaNeumaierSum(partial_sums, n_chunks + (remainder > 0 ? 1 : 0));
+    return binned_sum_value(sum);
+}
+
+double daxpy_sum_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
+    /*
+    daxpy_chunked and the sum of the result in one sweep: every chunk of y
+    is summed while it is being written, instead of being read back from
+    memory afterwards. The chunk sums are compensated and merged as such;
+    unlike sum_chunked, the last bit can depend on the chunk size.
+    */
+
+    if (n <= 0) {
+        return 0.0;
+    }
+
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::DaxpySum, n);
+    }
+    chunk_size = std::min(chunk_size, n);
+
+    int remainder = n % chunk_size;
+    // Process eventual smaller chunk first
+    CompensatedSum sum = daxpy_sum_partial(remainder, a, x, y);
+
+    for (int chunk_start = remainder; chunk_start < n; chunk_start += chunk_size) {
+        sum = compensated_merge(sum, daxpy_sum_partial(chunk_size, a, x + chunk_start, y + chunk_start));
+    }
+
+    return sum.sum + sum.c;
 }
 
 int main(int argc, char* argv[]) {
@@ -85,7 +97,6 @@ int main(int argc, char* argv[]) {
     const double TOLERANCE = 1e-15;
     const double a = 3.;
     const size_t ARRAY_SIZES[] = {10, 1000, 10000, 1000000, 100000000};
-    const size_t CHUNK_SIZES[] = {1, 4, 8, 10};
 
     // Test memory allocation on the stack and heap
     // for each array size and implementation of daxpy
@@ -108,7 +119,16 @@ int main(int argc, char* argv[]) {
             x[j] = 0.1;
         }
 
-        for (const size_t chunk_size: CHUNK_SIZES) {
+        // Chunk sizes: 0 for the one tuned for this host (timed now, on
+        // first use, rather than inside the timings below), then the
+        // candidates derived from the cache sizes, up to n
+        std::vector<int> chunk_sizes = chunk_size_candidates(ChunkedKernel::Daxpy, n);
+        chunk_sizes.insert(chunk_sizes.begin(), 0);
+        std::cout << "tuned chunk sizes: daxpy " << tuned_chunk_size(ChunkedKernel::Daxpy, n)
+                  << ", sum " << tuned_chunk_size(ChunkedKernel::Sum, n)
+                  << ", fused " << tuned_chunk_size(ChunkedKernel::DaxpySum, n) << std::endl;
+
+        for (const int chunk_size: chunk_sizes) {
  
             // Since the y array will be modified by the previous daxpy call,
             // have to reinitialize it.
@@ -120,7 +140,7 @@ int main(int argc, char* argv[]) {
             daxpy_chunked(n, a, x, y, chunk_size);
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double> elapsed = end - start;
-            std::cout << "chunk size " << chunk_size << "\n\t daxpy time: " << elapsed.count() << " seconds" << std::endl;
+            std::cout << "chunk size " << (chunk_size == 0 ? "tuned" : std::to_string(chunk_size)) << "\n\t daxpy time: " << elapsed.count() << " seconds" << std::endl;
             // Verify result
             for (size_t j = 0; j < n; j++) {
                 assert(fabs(y[j] - (7.1 + a * 0.1)) < TOLERANCE);
@@ -134,6 +154,24 @@ int main(int argc, char* argv[]) {
             std::cout << "\t sum time: " << elapsed.count() << " seconds" << std::endl;
             // Verify result
             assert(fabs(sum - n * (7.1 + a * 0.1)) < n*TOLERANCE);
+
+            // fused daxpy and sum, one sweep of y
+            for (size_t j = 0; j < n; j++) {
+                y[j] = 7.1;
+            }
+            start = std::chrono::high_resolution_clock::now();
+            auto fused_sum = daxpy_sum_chunked(n, a, x, y, chunk_size);
+            end = std::chrono::high_resolution_clock::now();
+            elapsed = end - start;
+            std::cout << "\t fused daxpy + sum time: " << elapsed.count() << " seconds" << std::endl;
+            // Verify result
+            for (size_t j = 0; j < n; j++) {
+                assert(fabs(y[j] - (7.1 + a * 0.1)) < TOLERANCE);
+            }
+            if (fabs(fused_sum - n * (7.1 + a * 0.1)) >= n*TOLERANCE) {
+                std::cerr << "Error in fused sum result: " << fused_sum << " != " << n * (7.1 + a * 0.1) << std::endl;
+                return 1;
+            }
         }
 
         delete[] x;
@@ -1,30 +1,22 @@
+#include <algorithm>
 #include <assert.h>
+#include <climits>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <chrono>
+#include <string>
+#include <vector>
 #include <unistd.h>
 #include <mpi.h>
 
-double KahanBabushkaNeumaierSum(const double *vec, int n) {
-    /*
-    Kahan-Babushka-Neumaier summation algorithm
-    This algorithm is a modification of the Kahan summation algorithm that uses two variables
-    to keep track of the compensation for lost low-order bits.
-    */
-
-    double sum = 0.0, c = 0.0;
-
-    for (int i = 0; i < n; i++) {
-        double t = sum + vec[i];
-        if (abs(sum) >= abs(vec[i])) {
-            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
-        } else {
-            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
-        }
-        sum = t;
-    }
-    return sum + c;
-}
+#include "daxpy.hpp"
+#include "daxpy_sum.hpp"
+#include "sum.hpp"
+#include "tuning.hpp"
+#ifdef SC4PS_HAVE_PARALLEL_HDF5
+#include "fileio.hpp" // 03-code-io/C++/hdf5
+#endif
 
 void daxpy_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
 
@@ -32,58 +24,85 @@ void daxpy_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
         return;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Daxpy, n);
     }
-    assert(chunk_size <= n);
+    chunk_size = std::min(chunk_size, n);
 
     int remainder = n % chunk_size;
     // Process eventual smaller chunk first
-    for (int i = 0; i < remainder; i++) {
-        y[i] += a * x[i];
-    }
+    daxpy(remainder, a, x, y);
 
     for (int chunk_start = remainder; chunk_start < n; chunk_start += chunk_size) {
-        for (int i = 0; i < chunk_size; i++) {
-            y[chunk_start + i] += a * x[chunk_start + i];
-        }
+        daxpy(chunk_size, a, x + chunk_start, y + chunk_start);
+    }
+}
+
+static void block_distribution(int n, int world_size, std::vector<int> &counts, std::vector<int> &displs) {
+    // Balanced blocks over all ranks, the first n % world_size ranks get
+    // one more element (as in the hdf5 mode)
+    counts.resize(world_size);
+    displs.resize(world_size);
+    int base = n / world_size, extra = n % world_size;
+    for (int rank = 0; rank < world_size; rank++) {
+        counts[rank] = base + (rank < extra ? 1 : 0);
+        displs[rank] = rank * base + std::min(rank, extra);
     }
 }
 
-void daxpy_chunked_parallel(int n, double a, double *x, double *y) {
+static void scatter_block(const double *vec, const std::vector<int> &counts, const std::vector<int> &displs,
+                          std::vector<double> &local, MPI_Comm comm) {
+    // Rank 0 keeps its block, the first one, in place in vec; the other
+    // ranks receive theirs into local
+    int this_rank;
+    MPI_Comm_rank(comm, &this_rank);
+    if (this_rank == 0) {
+        MPI_Scatterv(vec, counts.data(), displs.data(), MPI_DOUBLE, MPI_IN_PLACE, counts[0], MPI_DOUBLE, 0, comm);
+    } else {
+        local.resize(counts[this_rank]);
+        MPI_Scatterv(nullptr, nullptr, nullptr, MPI_DOUBLE, local.data(), counts[this_rank], MPI_DOUBLE, 0, comm);
+    }
+}
 
+static void gather_block(double *vec, const std::vector<int> &counts, const std::vector<int> &displs,
+                         const std::vector<double> &local, MPI_Comm comm) {
+    int this_rank;
+    MPI_Comm_rank(comm, &this_rank);
+    if (this_rank == 0) {
+        MPI_Gatherv(MPI_IN_PLACE, counts[0], MPI_DOUBLE, vec, counts.data(), displs.data(), MPI_DOUBLE, 0, comm);
+    } else {
+        MPI_Gatherv(local.data(), counts[this_rank], MPI_DOUBLE, nullptr, nullptr, nullptr, MPI_DOUBLE, 0, comm);
+    }
+}
+
+void daxpy_chunked_parallel(int n, double a, double *x, double *y, MPI_Comm comm=MPI_COMM_WORLD) {
+    /*
+    x and y live on rank 0 (the other ranks may pass nullptr). Both are
+    scattered in balanced blocks to all the ranks, rank 0 included, each
+    rank computes its block and the blocks of y are gathered back. Rank
+    0 works on its block in place, so a single rank is a plain daxpy.
+    */
     int world_size, this_rank;
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
-    MPI_Comm_rank(MPI_COMM_WORLD, &this_rank);
+    MPI_Comm_size(comm, &world_size);
+    MPI_Comm_rank(comm, &this_rank);
 
     if (n <= 0 || a == 0.0) {
         return;
     }
 
-    int n_workers = std::max(world_size - 1, 1);
-    int chunk_size = n / n_workers;
-    assert(chunk_size <= n);
-        
-    int remainder = n % n_workers;
+    std::vector<int> counts, displs;
+    block_distribution(n, world_size, counts, displs);
 
-    // Let the first rank process the remainder
-    if (this_rank == 0){
-        // Process eventual smaller chunk first
-        for (int i = 0; i < remainder; i++) {
-            y[i] += a * x[i];
-        }
-    
-        // Rank 0 collects results from all other ranks
-        for (int rank = 1; rank < world_size; rank++) {
-            int recv_start_index = remainder + (rank - 1) * chunk_size;
-            MPI_Recv(y + recv_start_index, chunk_size, MPI_DOUBLE, rank, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
+    std::vector<double> x_local, y_local;
+    scatter_block(x, counts, displs, x_local, comm);
+    scatter_block(y, counts, displs, y_local, comm);
+    if (this_rank == 0) {
+        daxpy(counts[0], a, x, y);
     } else {
-        for (int i = 0; i < chunk_size; i++) {
-            y[i] += a * x[i];
-        }
-        MPI_Send(y, chunk_size, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+        daxpy(counts[this_rank], a, x_local.data(), y_local.data());
     }
+    gather_block(y, counts, displs, y_local, comm);
 }
 
 double sum_chunked(int n, double *x, int chunk_size=0) {
@@ -92,33 +111,60 @@ double sum_chunked(int n, double *x, int chunk_size=0) {
         return 0.0;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Sum, n);
     }
-    assert(chunk_size <= n);
+    chunk_size = std::min(chunk_size, n);
 
     int n_chunks = n / chunk_size;
     int remainder = n % chunk_size;
-    double* partial_sums = new double[n_chunks + (remainder > 0 ? 1 : 0)];
+
+    // All chunks go to one binned accumulator, whose result does not
+    // depend on how the vector is cut: same bits for any chunk size
+    BinnedSum sum;
+    binned_sum_clear(sum);
 
     // Process eventual smaller chunk first
-    // but put it in last element of partial_sums array
-    double sum = 0.0;
-    for (int i = 0; i < remainder; i++) {
-        sum += x[i];
-    }
-    partial_sums[n_chunks - (remainder > 0 ? 0 : 1)] = sum;
+    binned_sum_add(sum, x, remainder);
 
     // Now process all full chunks;
     for (int chunk = 0, start_index = remainder; chunk < n_chunks; chunk++, start_index += chunk_size) {
-        partial_sums[chunk] = KahanBabushkaNeumaierSum(x + start_index, chunk_size);
+        binned_sum_add(sum, x + start_index, chunk_size);
     }
 
-    // Now sum up all partial sums
-    return KahanBabushkaNeumaierSum(partial_sums, n_chunks + (remainder > 0 ? 1 : 0));
+    return binned_sum_value(sum);
+}
+
+static void binned_sum_merge_op(void *in, void *inout, int *len, MPI_Datatype *) {
+    const BinnedSum *b = static_cast<const BinnedSum*>(in);
+    BinnedSum *a = static_cast<BinnedSum*>(inout);
+    for (int i = 0; i < *len; i++) {
+        binned_sum_merge(a[i], b[i]);
+    }
+}
+
+static void binned_sum_mpi_types(MPI_Datatype &type, MPI_Op &op) {
+    // created once, after MPI_Init; the merge is exact, hence commutative
+    static MPI_Datatype binned_type = MPI_DATATYPE_NULL;
+    static MPI_Op binned_op = MPI_OP_NULL;
+    if (binned_type == MPI_DATATYPE_NULL) {
+        MPI_Type_contiguous(sizeof(BinnedSum), MPI_BYTE, &binned_type);
+        MPI_Type_commit(&binned_type);
+        MPI_Op_create(binned_sum_merge_op, 1, &binned_op);
+    }
+    type = binned_type;
+    op = binned_op;
 }
 
 double sum_chunked_parallel(int n, double *x) {
+    /*
+    x lives on rank 0 and is scattered in balanced blocks to all the
+    ranks, rank 0 included. Every rank sums its block into a binned
+    accumulator and the accumulators are merged, exactly, by MPI_Reduce
+    with a custom MPI_Op: the result is bit-identical for any number of
+    ranks.
+    */
     int world_size, this_rank;
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &this_rank);
@@ -127,49 +173,244 @@ double sum_chunked_parallel(int n, double *x) {
         return 0.0;
     }
 
-    int n_workers = std::max(world_size - 1, 1);
-    int chunk_size = n / n_workers;
+    std::vector<int> counts, displs;
+    block_distribution(n, world_size, counts, displs);
+
+    std::vector<double> x_local;
+    scatter_block(x, counts, displs, x_local, MPI_COMM_WORLD);
+
+    BinnedSum local, total;
+    binned_sum_clear(local);
+    binned_sum_clear(total);
+    binned_sum_add(local, this_rank == 0 ? x : x_local.data(), counts[this_rank]);
+
+    MPI_Datatype binned_type;
+    MPI_Op binned_op;
+    binned_sum_mpi_types(binned_type, binned_op);
+    MPI_Reduce(&local, &total, 1, binned_type, binned_op, 0, MPI_COMM_WORLD);
+
+    // Only rank 0 has the sum, the others return 0
+    return this_rank == 0 ? binned_sum_value(total) : 0.0;
+}
+
+static void compensated_merge_op(void *in, void *inout, int *len, MPI_Datatype *) {
+    const CompensatedSum *b = static_cast<const CompensatedSum*>(in);
+    CompensatedSum *a = static_cast<CompensatedSum*>(inout);
+    for (int i = 0; i < *len; i++) {
+        a[i] = compensated_merge(a[i], b[i]);
+    }
+}
+
+static void compensated_sum_mpi_types(MPI_Datatype &type, MPI_Op &op) {
+    // created once, after MPI_Init; compensated_merge is commutative
+    static MPI_Datatype compensated_type = MPI_DATATYPE_NULL;
+    static MPI_Op compensated_op = MPI_OP_NULL;
+    if (compensated_type == MPI_DATATYPE_NULL) {
+        MPI_Type_contiguous(2, MPI_DOUBLE, &compensated_type);
+        MPI_Type_commit(&compensated_type);
+        MPI_Op_create(compensated_merge_op, 1, &compensated_op);
+    }
+    type = compensated_type;
+    op = compensated_op;
+}
 
-    int remainder = n % n_workers;
-    double* partial_sums = new double[world_size]; // takes into account remainder processed by rank 0
+double daxpy_sum_chunked_parallel(int n, double a, double *x, double *y) {
+    /*
+    daxpy_chunked_parallel and the sum of the result in one sweep: every
+    rank sums its block of y while computing it, so the blocks need not
+    be scattered a second time for sum_chunked_parallel. The
+    compensated partial sums meet in an MPI_Reduce on rank 0.
+    */
+    int world_size, this_rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &this_rank);
 
+    if (n <= 0) {
+        return 0.0;
+    }
+
+    std::vector<int> counts, displs;
+    block_distribution(n, world_size, counts, displs);
+
+    std::vector<double> x_local, y_local;
+    scatter_block(x, counts, displs, x_local, MPI_COMM_WORLD);
+    scatter_block(y, counts, displs, y_local, MPI_COMM_WORLD);
+
+    CompensatedSum local, total = {0.0, 0.0};
     if (this_rank == 0) {
-        if (world_size < 2) {
-            // If there is only one rank, just return the sum of the whole array
-            partial_sums[0] = KahanBabushkaNeumaierSum(x, n);
-        } else {
-            // Rank 0 will send chunks to all other ranks
-            for (int rank = 1; rank < world_size; rank++) {
-                int start_index = remainder + (rank - 1) * chunk_size;
-                MPI_Send(x + start_index, chunk_size, MPI_DOUBLE, rank, 0, MPI_COMM_WORLD);
-            }
-            // Rank 0 processes the eventual remainder
-            partial_sums[0] = KahanBabushkaNeumaierSum(x, remainder);
-        }
+        local = daxpy_sum_partial(counts[0], a, x, y);
     } else {
-        // All other ranks receive their chunk
-        delete[] partial_sums; // Clean up memory allocated for partial sums
-        MPI_Recv(x, chunk_size, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        local = daxpy_sum_partial(counts[this_rank], a, x_local.data(), y_local.data());
+    }
+    gather_block(y, counts, displs, y_local, MPI_COMM_WORLD);
+
+    MPI_Datatype compensated_type;
+    MPI_Op compensated_op;
+    compensated_sum_mpi_types(compensated_type, compensated_op);
+    MPI_Reduce(&local, &total, 1, compensated_type, compensated_op, 0, MPI_COMM_WORLD);
+
+    // Only rank 0 has the sum, the others return 0
+    return this_rank == 0 ? total.sum + total.c : 0.0;
+}
+
+static const int SCALING_REPEAT = 3;
+
+static void time_daxpy(int n, double a, MPI_Comm comm, double &resident, double &scatter_gather) {
+    /*
+    Best of SCALING_REPEAT times, each the time of the slowest rank:
+    resident is the daxpy of data already distributed, every rank
+    holding (and having first touched) its own block, scatter_gather
+    daxpy_chunked_parallel on vectors that live on rank 0.
+    */
+    int world_size, this_rank;
+    MPI_Comm_size(comm, &world_size);
+    MPI_Comm_rank(comm, &this_rank);
+
+    std::vector<int> counts, displs;
+    block_distribution(n, world_size, counts, displs);
+
+    std::vector<double> x_local(counts[this_rank], 0.1), y_local(counts[this_rank], 7.1);
+    resident = INFINITY;
+    for (int r = 0; r < SCALING_REPEAT; r++) {
+        MPI_Barrier(comm);
+        auto start = std::chrono::high_resolution_clock::now();
+        daxpy(counts[this_rank], a, x_local.data(), y_local.data());
+        auto end = std::chrono::high_resolution_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, comm);
+        resident = std::min(resident, t);
     }
+    x_local.clear();
+    x_local.shrink_to_fit();
+    y_local.clear();
+    y_local.shrink_to_fit();
 
-    // Now sum up received data if rank 0
+    std::vector<double> x, y;
     if (this_rank == 0) {
-        for (int i = 1; i < world_size; i++) {
-            MPI_Recv(partial_sums + i, 1, MPI_DOUBLE, i, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        x.assign(n, 0.1);
+        y.assign(n, 7.1);
+    }
+    scatter_gather = INFINITY;
+    for (int r = 0; r < SCALING_REPEAT; r++) {
+        MPI_Barrier(comm);
+        auto start = std::chrono::high_resolution_clock::now();
+        daxpy_chunked_parallel(n, a, x.data(), y.data(), comm);
+        auto end = std::chrono::high_resolution_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, comm);
+        scatter_gather = std::min(scatter_gather, t);
+    }
+}
+
+void daxpy_scaling(int n_strong, int n_per_rank, double a) {
+    /*
+    Strong scaling (n_strong elements over 1, 2, 4, ... ranks, up to all
+    of them) and weak scaling (n_per_rank elements per rank), on
+    sub-communicators of the first ranks of MPI_COMM_WORLD while the
+    others wait. Speedup and efficiency are relative to one rank:
+    t1 / tp and t1 / (p tp) for strong scaling, t1 / tp for weak.
+    */
+    int world_size, this_rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &this_rank);
+
+    std::vector<int> rank_counts;
+    for (int p = 1; p < world_size; p *= 2) {
+        rank_counts.push_back(p);
+    }
+    rank_counts.push_back(world_size);
+
+    for (bool weak: {false, true}) {
+        if (this_rank == 0) {
+            std::cout << "----------------------------------------" << std::endl;
+            if (weak) {
+                std::cout << "Weak scaling, n = " << n_per_rank << " per rank" << std::endl;
+            } else {
+                std::cout << "Strong scaling, n = " << n_strong << std::endl;
+            }
+        }
+        double resident_1 = 0.0, scatter_gather_1 = 0.0;
+        for (int p: rank_counts) {
+            MPI_Comm comm;
+            MPI_Comm_split(MPI_COMM_WORLD, this_rank < p ? 0 : MPI_UNDEFINED, this_rank, &comm);
+            double resident = 0.0, scatter_gather = 0.0;
+            if (comm != MPI_COMM_NULL) {
+                int n = weak ? n_per_rank * p : n_strong;
+                time_daxpy(n, a, comm, resident, scatter_gather);
+                MPI_Comm_free(&comm);
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            if (this_rank == 0) {
+                if (p == 1) {
+                    resident_1 = resident;
+                    scatter_gather_1 = scatter_gather;
+                }
+                double ratio = resident_1 / resident, sg_ratio = scatter_gather_1 / scatter_gather;
+                std::cout << p << " rank(s): resident " << resident << " seconds (";
+                if (weak) {
+                    std::cout << "efficiency " << 100.0 * ratio << "%), scatter/gather " << scatter_gather
+                              << " seconds (efficiency " << 100.0 * sg_ratio << "%)" << std::endl;
+                } else {
+                    std::cout << "speedup " << ratio << ", efficiency " << 100.0 * ratio / p << "%), scatter/gather "
+                              << scatter_gather << " seconds (speedup " << sg_ratio << ")" << std::endl;
+                }
+            }
         }
-        return KahanBabushkaNeumaierSum(partial_sums, world_size);
-    } else {
-        // All other ranks compute their partial sums and send to 0
-        double local_sum = KahanBabushkaNeumaierSum(x, chunk_size);
-        MPI_Send(&local_sum, 1, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
-        return 0.0; // Return 0, as this rank does not contribute to the final sum
     }
 }
 
+#ifdef SC4PS_HAVE_PARALLEL_HDF5
+void daxpy_hdf5_parallel(double a, const std::string &fname_x, const std::string &fname_y, const std::string &fname_d) {
+    /*
+    daxpy on HDF5 files through MPI-IO
+    Every rank opens the inputs collectively and reads, computes and
+    writes only its own contiguous slab of the vectors: no rank ever
+    holds more than n / world_size elements and the file system serves
+    all of them in parallel, instead of everything going through rank 0.
+    */
+    int world_size, this_rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &this_rank);
+
+    hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+    H5Pset_fapl_mpio(fapl_id, MPI_COMM_WORLD, MPI_INFO_NULL);
+    hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+    H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+
+    // Block distribution, the first n % world_size ranks get one more element
+    hsize_t n = vector_length_hdf5(fname_x, "vector_data", fapl_id);
+    hsize_t base = n / world_size, extra = n % world_size;
+    hsize_t count = base + (hsize_t(this_rank) < extra ? 1 : 0);
+    hsize_t offset = this_rank * base + std::min(hsize_t(this_rank), extra);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    double *x = nullptr, *y = nullptr;
+    read_vector_hdf5_slab(fname_x, "vector_data", offset, count, x, fapl_id, dxpl_id);
+    read_vector_hdf5_slab(fname_y, "vector_data", offset, count, y, fapl_id, dxpl_id);
+    daxpy(count, a, x, y);
+    dump_vector_hdf5_slab(n, fname_d, "vector_data", offset, count, y, fapl_id, dxpl_id);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    if (this_rank == 0) {
+        std::cout << "HDF5 daxpy of n = " << n << " into <" << fname_d << "> time: " << elapsed.count() << " seconds ("
+                  << 3e-9 * n * sizeof(double) / elapsed.count() << " GB/s)" << std::endl;
+    }
+
+    delete[] x;
+    delete[] y;
+    H5Pclose(dxpl_id);
+    H5Pclose(fapl_id);
+}
+#endif
 
 int main(int argc, char* argv[]) {
-    // Will use MPI with rank 0 as main process, sending data to all other ranks
-    // and receiving results back from them.
+    // Will use MPI with rank 0 holding the vectors, scattering them to all
+    // ranks (itself included) and gathering the results back.
     MPI_Init(&argc, &argv);
 
     int world_size, this_rank;
@@ -187,40 +428,76 @@ int main(int argc, char* argv[]) {
     
     const double TOLERANCE = 1e-10;
     const double a = 3.;
+
+    // 09daxpyCpp_MPI hdf5 <x.h5> <y.h5> <d.h5>: parallel file I/O mode
+    if (argc > 1 && std::string(argv[1]) == "hdf5") {
+#ifdef SC4PS_HAVE_PARALLEL_HDF5
+        if (argc != 5) {
+            if (this_rank == 0)
+                std::cerr << "Usage: " << argv[0] << " hdf5 <x.h5> <y.h5> <d.h5>" << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+        daxpy_hdf5_parallel(a, argv[2], argv[3], argv[4]);
+        MPI_Finalize();
+        return 0;
+#else
+        if (this_rank == 0)
+            std::cerr << "[error] built without parallel HDF5, the hdf5 mode is not available" << std::endl;
+        MPI_Finalize();
+        return 1;
+#endif
+    }
+
+    // 09daxpyCpp_MPI scaling [n] [n per rank]: strong and weak scaling mode
+    if (argc > 1 && std::string(argv[1]) == "scaling") {
+        int n_strong = argc > 2 ? std::atoi(argv[2]) : 1 << 24;
+        int n_per_rank = argc > 3 ? std::atoi(argv[3]) : 1 << 22;
+        if (n_strong <= 0 || n_per_rank <= 0 || (long long)n_per_rank * world_size > INT_MAX || argc > 4) {
+            if (this_rank == 0)
+                std::cerr << "Usage: " << argv[0] << " scaling [n] [n per rank]" << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+        daxpy_scaling(n_strong, n_per_rank, a);
+        MPI_Finalize();
+        return 0;
+    }
     const size_t ARRAY_SIZES[] = {10, 1000, 10000, 1000000, 100000000};
 
     // Test memory allocation on the stack and heap
     // for each array size and implementation of daxpy
     for (const size_t n: ARRAY_SIZES) {
 
-        // Initialize on rank 0 and send a chunk to all
+        // Initialize on rank 0, which scatters a block to all
         if (this_rank == 0) {
             std::cout << "----------------------------------------" << std::endl;
             std::cout << "Testing with n = " << n << std::endl;
         }
 
-        int chunk_size = n / std::max(world_size-1, 1);
-
-        // Allocate memory on the heap for each rank, spare some messages
-        double *x, *y;
+        // Allocate memory on the heap of rank 0 only, the other ranks
+        // get their blocks from the scatters
+        double *x = nullptr, *y = nullptr;
         if (this_rank == 0) {
             x = new double[n];
             y = new double[n];
-        } else {
-            x = new double[chunk_size];
-            y = new double[chunk_size];
-        }
 
-        // Check if memory allocation was successful
-        if (x == nullptr || y == nullptr) {
-            std::cerr << "Memory allocation failed on rank " << this_rank<< std::endl;
-            MPI_Abort(MPI_COMM_WORLD, 1);
-            return 1;
-        }
-        // Initialize x and y
-        for (size_t j = 0; j < (this_rank == 0 ? n : chunk_size); j++) {
-            x[j] = 0.1;
-            y[j] = 7.1;
+            // Check if memory allocation was successful
+            if (x == nullptr || y == nullptr) {
+                std::cerr << "Memory allocation failed on rank " << this_rank<< std::endl;
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+            // Initialize x and y
+            for (size_t j = 0; j < n; j++) {
+                x[j] = 0.1;
+                y[j] = 7.1;
+            }
+
+            // chunk sizes of the serial versions, tuned now rather than
+            // inside their timings
+            tuned_chunk_size(ChunkedKernel::Daxpy, n);
+            tuned_chunk_size(ChunkedKernel::Sum, n);
         }
 
         // Perform daxpy with MPI
@@ -243,7 +520,7 @@ int main(int argc, char* argv[]) {
                 y[j] = 7.1;
             }
             start = std::chrono::high_resolution_clock::now();
-            daxpy_chunked(n, a, x, y, chunk_size);
+            daxpy_chunked(n, a, x, y);
             end = std::chrono::high_resolution_clock::now();
             elapsed = end - start;
             std::cout << "daxpy (no MPI) time: " << elapsed.count() << " seconds" << std::endl;
@@ -264,10 +541,43 @@ int main(int argc, char* argv[]) {
             }
 
             start = std::chrono::high_resolution_clock::now();
-            sum = sum_chunked(n, y, chunk_size);
+            auto serial_sum = sum_chunked(n, y);
             end = std::chrono::high_resolution_clock::now();
             elapsed = end - start;
             std::cout << "sum (no MPI) time: " << elapsed.count() << " seconds" << std::endl;
+            // Binned sums do not depend on the decomposition: same bits
+            if (serial_sum != sum) {
+                std::cerr << "Error: sum is not reproducible: " << serial_sum << " != " << sum << std::endl;
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
+        }
+
+        // fused daxpy and sum with MPI, one sweep of y
+        if (this_rank == 0) {
+            for (size_t j = 0; j < n; j++) {
+                y[j] = 7.1;
+            }
+        }
+        start = std::chrono::high_resolution_clock::now();
+        sum = daxpy_sum_chunked_parallel(n, a, x, y);
+        end = std::chrono::high_resolution_clock::now();
+        elapsed = end - start;
+        if (this_rank == 0) {
+            std::cout << "fused daxpy + sum time: " << elapsed.count() << " seconds" << std::endl;
+            // Verify result
+            for (size_t j = 0; j < n; j++) {
+                if (fabs(y[j] - (7.1 + a * 0.1)) > TOLERANCE) {
+                    std::cerr << "Error in fused daxpy result at index " << j << ": " << y[j] << " != " << (7.1 + a * 0.1) << std::endl;
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                    return 1;
+                }
+            }
+            if (fabs(sum - n * (7.1 + a * 0.1)) > n*TOLERANCE) {
+                std::cerr << "Error in fused sum result: " << sum << " != " << n * (7.1 + a * 0.1) << std::endl;
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                return 1;
+            }
         }
 
         delete[] x;
@@ -1,49 +1,29 @@
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <iostream>
 #include <chrono>
-
-double KahanBabushkaNeumaierSum(const double *vec, int n) {
-    /*
-    Kahan-Babushka-Neumaier summation algorithm
-    This algorithm is a modification of the Kahan summation algorithm that uses two variables
-    to keep track of the compensation for lost low-order bits.
-    */
-
-    double sum = 0.0, c = 0.0;
-
-    for (int i = 0; i < n; i++) {
-        double t = sum + vec[i];
-        if (abs(sum) >= abs(vec[i])) {
-            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
-        } else {
-            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
-        }
-        sum = t;
-    }
-    return sum + c;
-}
-
-double KahanBabushkaNeumaierSum_parallel(const double *vec, int n) {
-    /*
-    Kahan-Babushka-Neumaier summation algorithm
-    This algorithm is a modification of the Kahan summation algorithm that uses two variables
-    to keep track of the compensation for lost low-order bits.
-    */
-
-    double sum = 0.0, c = 0.0;
-
-    #pragma omp parallel for reduction(+:sum,c)
-    for (int i = 0; i < n; i++) {
-        double t = sum + vec[i];
-        if (abs(sum) >= abs(vec[i])) {
-            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
-        } else {
-            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
-        }
-        sum = t;
-    }
-    return sum + c;
+#include <string>
+#include <vector>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "daxpy.hpp"
+#include "daxpy_sum.hpp"
+#include "numa.hpp"
+#include "sum.hpp"
+#include "tuning.hpp"
+
+static void thread_slice(size_t n, size_t &begin, size_t &end) {
+    // numa_static_slice of the calling thread in the current team: the
+    // elements whose pages numa_alloc_first_touch placed on its node
+    int thread = 0, threads = 1;
+#if defined(_OPENMP)
+    thread = omp_get_thread_num();
+    threads = omp_get_num_threads();
+#endif
+    numa_static_slice(n, thread, threads, begin, end);
 }
 
 void daxpy_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
@@ -52,21 +32,18 @@ void daxpy_chunked(int n, double a, double *x, double *y, int chunk_size=0) {
         return;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Daxpy, n);
     }
-    assert(chunk_size <= n);
+    chunk_size = std::min(chunk_size, n);
 
     int remainder = n % chunk_size;
     // Process eventual smaller chunk first
-    for (int i = 0; i < remainder; i++) {
-        y[i] += a * x[i];
-    }
+    daxpy(remainder, a, x, y);
 
     for (int chunk_start = remainder; chunk_start < n; chunk_start += chunk_size) {
-        for (int i = 0; i < chunk_size; i++) {
-            y[chunk_start + i] += a * x[chunk_start + i];
-        }
+        daxpy(chunk_size, a, x + chunk_start, y + chunk_start);
     }
 }
 
@@ -76,21 +53,20 @@ void daxpy_chunked_parallel(int n, double a, double *x, double *y, int chunk_siz
         return;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
-    }
-    assert(chunk_size <= n);
-
-    int remainder = n % chunk_size;
-    // Process eventual smaller chunk first
-    for (int i = 0; i < remainder; i++) {
-        y[i] += a * x[i];
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Daxpy, n, true);
     }
-
-    #pragma omp parallel for
-    for (int chunk_start = remainder; chunk_start < n; chunk_start += chunk_size) {
-        for (int i = 0; i < chunk_size; i++) {
-            y[chunk_start + i] += a * x[chunk_start + i];
+    chunk_size = std::min(chunk_size, n);
+
+    // Each thread walks its own slice chunk by chunk, ending with a
+    // shorter chunk if the slice is not a multiple of chunk_size
+    #pragma omp parallel
+    {
+        size_t begin, end;
+        thread_slice(n, begin, end);
+        for (size_t chunk_start = begin; chunk_start < end; chunk_start += chunk_size) {
+            daxpy(std::min<size_t>(chunk_size, end - chunk_start), a, x + chunk_start, y + chunk_start);
         }
     }
 }
@@ -101,43 +77,86 @@ void daxpy_parallel(int n, double a, double *x, double *y) {
         return;
     }
 
-    #pragma omp parallel for
-    for (int i = 0; i < n; i++) {
-        y[i] += a * x[i];
+    // the split of numa_alloc_first_touch, whatever the OpenMP runtime:
+    // each thread reads and writes the pages it placed on its own node
+    #pragma omp parallel
+    {
+        size_t begin, end;
+        thread_slice(n, begin, end);
+        for (size_t i = begin; i < end; i++) {
+            y[i] += a * x[i];
+        }
     }
 
 }
 
+struct NodeBandwidth {
+    int threads;
+    double bytes;
+    double seconds; // of the slowest thread of the node
+};
+
+std::vector<NodeBandwidth> daxpy_parallel_per_node(int n, double a, double *x, double *y) {
+    /*
+    daxpy_parallel with each thread timing its own slice, grouped by the
+    node the thread runs on: the bandwidth each node's memory delivers
+    to its threads, 24 bytes (x and y read, y written) per element.
+    */
+    std::vector<NodeBandwidth> per_node(numa_node_count(), {0, 0.0, 0.0});
+
+    #pragma omp parallel
+    {
+        size_t begin, end;
+        thread_slice(n, begin, end);
+
+        #pragma omp barrier
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = begin; i < end; i++) {
+            y[i] += a * x[i];
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(stop - start).count();
+
+        int node = numa_current_node();
+        #pragma omp critical
+        {
+            per_node[node].threads++;
+            per_node[node].bytes += 3.0 * sizeof(double) * (end - begin);
+            per_node[node].seconds = std::max(per_node[node].seconds, seconds);
+        }
+    }
+    return per_node;
+}
+
 double sum_chunked(int n, double *x, int chunk_size=0) {
 
     if (n <= 0) {
         return 0.0;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Sum, n);
     }
-    assert(chunk_size <= n);
+    chunk_size = std::min(chunk_size, n);
 
     int n_chunks = n / chunk_size;
     int remainder = n % chunk_size;
-    double* partial_sums = new double[n_chunks + (remainder > 0 ? 1 : 0)];
+
+    // All chunks go to one binned accumulator, whose result does not
+    // depend on how the vector is cut: same bits for any chunk size
+    BinnedSum sum;
+    binned_sum_clear(sum);
 
     // Process eventual smaller chunk first
-    // but put it in last element of partial_sums array
-    double sum = 0.0;
-    for (int i = 0; i < remainder; i++) {
-        sum += x[i];
-    }
-    partial_sums[n_chunks - (remainder > 0 ? 0 : 1)] = sum;
+    binned_sum_add(sum, x, remainder);
 
     // Now process all full chunks;
     for (int chunk = 0, start_index = remainder; chunk < n_chunks; chunk++, start_index += chunk_size) {
-        partial_sums[chunk] = KahanBabushkaNeumaierSum(x + start_index, chunk_size);
+        binned_sum_add(sum, x + start_index, chunk_size);
     }
 
-    // Now sum up all partial sums
-    return KahanBabushkaNeumaierSum(partial_sums, n_chunks + (remainder > 0 ? 1 : 0));
+    return binned_sum_value(sum);
 }
 
 double sum_chunked_parallel(int n, double *x, int chunk_size=0) {
@@ -146,41 +165,109 @@ double sum_chunked_parallel(int n, double *x, int chunk_size=0) {
         return 0.0;
     }
 
-    if (chunk_size <= 1) {
-        chunk_size = n; // default chunk size
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::Sum, n, true);
+    }
+    chunk_size = std::min(chunk_size, n);
+
+    // Each thread sums the chunks of its own slice into its own binned
+    // accumulator, and merging them is exact, so neither the number of
+    // threads nor the order of the reduction changes the result
+    BinnedSum total;
+    binned_sum_clear(total);
+    #pragma omp parallel reduction(binned_merge: total)
+    {
+        size_t begin, end;
+        thread_slice(n, begin, end);
+        for (size_t chunk_start = begin; chunk_start < end; chunk_start += chunk_size) {
+            binned_sum_add(total, x + chunk_start, std::min<size_t>(chunk_size, end - chunk_start));
+        }
     }
-    assert(chunk_size <= n);
 
-    int n_chunks = n / chunk_size;
-    int remainder = n % chunk_size;
-    double* partial_sums = new double[n_chunks + (remainder > 0 ? 1 : 0)];
+    return binned_sum_value(total);
+}
 
-    // Process eventual smaller chunk first
-    // but put it in last element of partial_sums array
-    double sum = 0.0;
-    for (int i = 0; i < remainder; i++) {
-        sum += x[i];
+double daxpy_sum_chunked_parallel(int n, double a, double *x, double *y, int chunk_size=0) {
+    /*
+    daxpy_chunked_parallel and the sum of the result in one sweep: each
+    chunk of y is summed while it is written, and the compensated sums of
+    the chunks are merged along the fixed pairwise tree of
+    KahanBabushkaNeumaierSum_parallel. The chunks, not the threads, define
+    the partial sums, so for a given chunk size the result is
+    bit-identical for any number of threads.
+    The chunks are cut from the start of y, the threads write their own
+    numa_static_slice: a chunk cut by a slice boundary is updated by both
+    threads, then summed after the barrier by the one holding its start,
+    as daxpy_sum_partial would have (same operations, same bits).
+    */
+
+    if (n <= 0) {
+        return 0.0;
     }
-    partial_sums[n_chunks - (remainder > 0 ? 0 : 1)] = sum;
 
-    // Now process all full chunks;
-    #pragma omp parallel for
-    for (int chunk = 0; chunk < n_chunks; chunk++) {
-        int start_index = remainder + chunk * chunk_size;
-        partial_sums[chunk] = KahanBabushkaNeumaierSum(x + start_index, chunk_size);
+    if (chunk_size <= 0) {
+        // default chunk size, tuned for this host
+        chunk_size = tuned_chunk_size(ChunkedKernel::DaxpySum, n, true);
     }
+    chunk_size = std::min(chunk_size, n);
+
+    // the last chunk takes the eventual smaller remainder
+    int n_chunks = (n + chunk_size - 1) / chunk_size;
+    std::vector<CompensatedSum> partial(n_chunks);
+
+    #pragma omp parallel
+    {
+        size_t begin, end;
+        thread_slice(n, begin, end);
+        // chunks [first, last) lie entirely in the slice, [begin, head_end)
+        // and [tail_begin, end) are the pieces of the chunks cut by its ends
+        size_t first = (begin + chunk_size - 1) / chunk_size;
+        size_t last = end == size_t(n) ? n_chunks : end / chunk_size;
+        size_t head_end = std::min(end, first * chunk_size);
+        size_t tail_begin = std::max(head_end, std::min(end, last * chunk_size));
+
+        daxpy(head_end - begin, a, x + begin, y + begin);
+        for (size_t chunk = first; chunk < last; chunk++) {
+            size_t start_index = chunk * chunk_size;
+            partial[chunk] = daxpy_sum_partial(std::min<size_t>(chunk_size, n - start_index), a, x + start_index, y + start_index);
+        }
+        daxpy(end - tail_begin, a, x + tail_begin, y + tail_begin);
 
-    // Now sum up all partial sums
-    return KahanBabushkaNeumaierSum(partial_sums, n_chunks + (remainder > 0 ? 1 : 0));
-}
+        #pragma omp barrier
+        if (tail_begin < end) {
+            size_t chunk = tail_begin / chunk_size;
+            partial[chunk] = KahanBabushkaNeumaierSum_partial(y + tail_begin, std::min<size_t>(chunk_size, n - tail_begin));
+        }
+    }
 
+    CompensatedSum total = compensated_merge_pairwise(partial.data(), n_chunks);
+    return total.sum + total.c;
+}
 
 int main(int argc, char* argv[]) {
     
     const double TOLERANCE = 1e-10;
     const double a = 3.;
     const size_t ARRAY_SIZES[] = {10, 1000, 10000, 1000000, 100000000};
-    const size_t CHUNK_SIZES[] = {1, 4, 8, 10};
+
+    // summation method of the parallel sum: kbn (default), reproducible or exact
+    SumMethod sum_method = SumMethod::KBN;
+    // thread placement: none (default, up to the OpenMP runtime), compact or scatter
+    Affinity affinity = Affinity::None;
+    if ((argc > 1 && !sum_method_from_name(argv[1], sum_method)) ||
+        (argc > 2 && !affinity_from_name(argv[2], affinity))) {
+        std::cerr << "Usage: " << argv[0] << " [kbn|reproducible|exact] [none|compact|scatter]" << std::endl;
+        return 1;
+    }
+
+    // Pinned before any page is touched: first touch places the pages on
+    // the node of the thread writing them, which must stay there
+    if (affinity != Affinity::None) {
+        int pinned = pin_threads(affinity);
+        std::cout << "pinned " << pinned << " threads (" << affinity_name(affinity) << ") over "
+                  << numa_node_count() << " NUMA node(s)" << std::endl;
+    }
 
     // Test memory allocation on the stack and heap
     // for each array size and implementation of daxpy
@@ -189,34 +276,41 @@ int main(int argc, char* argv[]) {
         std::cout << "----------------------------------------" << std::endl;
         std::cout << "Testing with n = " << n << std::endl;
 
-        // Allocate memory on the heap
-        double *x = new double[n];
-        double *y = new double[n];
+        // Allocate memory on the heap, first touched by the threads that
+        // use it (rather than all on the node of the master thread)
+        double *x = numa_alloc_first_touch(n, 0.1);
+        double *y = numa_alloc_first_touch(n, 7.1);
 
         // Check if memory allocation was successful
         if (x == nullptr || y == nullptr) {
             std::cerr << "Memory allocation failed" << std::endl;
             return 1;
         }
-        // Initialize x
-        for (size_t j = 0; j < n; j++) {
-            x[j] = 0.1;
-        }
 
-        for (const size_t chunk_size: CHUNK_SIZES) {
+        // Chunk sizes: 0 for the one tuned for this host (timed now, on
+        // first use, rather than inside the timings below), then the
+        // candidates derived from the cache sizes, up to n
+        std::vector<int> chunk_sizes = chunk_size_candidates(ChunkedKernel::Daxpy, n);
+        chunk_sizes.insert(chunk_sizes.begin(), 0);
+        std::cout << "tuned chunk sizes: daxpy " << tuned_chunk_size(ChunkedKernel::Daxpy, n)
+                  << ", sum " << tuned_chunk_size(ChunkedKernel::Sum, n)
+                  << ", fused " << tuned_chunk_size(ChunkedKernel::DaxpySum, n)
+                  << ", parallel daxpy " << tuned_chunk_size(ChunkedKernel::Daxpy, n, true)
+                  << ", parallel sum " << tuned_chunk_size(ChunkedKernel::Sum, n, true)
+                  << ", parallel fused " << tuned_chunk_size(ChunkedKernel::DaxpySum, n, true) << std::endl;
+
+        for (const int chunk_size: chunk_sizes) {
  
             // Since the y array will be modified by the previous daxpy call,
             // have to reinitialize it.
-            for (size_t j = 0; j < n; j++) {
-                y[j] = 7.1;
-            }
+            parallel_fill(n, 7.1, y);
 
             // chunked implementation
             auto start = std::chrono::high_resolution_clock::now();
             daxpy_chunked(n, a, x, y, chunk_size);
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double> elapsed = end - start;
-            std::cout << "chunk size " << chunk_size << "\n\t daxpy time: " << elapsed.count() << " seconds" << std::endl;
+            std::cout << "chunk size " << (chunk_size == 0 ? "tuned" : std::to_string(chunk_size)) << "\n\t daxpy time: " << elapsed.count() << " seconds" << std::endl;
             // Verify result
             for (size_t j = 0; j < n; j++) {
                 assert(fabs(y[j] - (7.1 + a * 0.1)) < TOLERANCE);
@@ -234,9 +328,7 @@ int main(int argc, char* argv[]) {
             // chunked parallel implementation
             // Since the y array will be modified by the previous daxpy call,
             // have to reinitialize it.
-            for (size_t j = 0; j < n; j++) {
-                y[j] = 7.1;
-            }
+            parallel_fill(n, 7.1, y);
             start = std::chrono::high_resolution_clock::now();
             daxpy_chunked_parallel(n, a, x, y, chunk_size);
             end = std::chrono::high_resolution_clock::now();
@@ -255,13 +347,32 @@ int main(int argc, char* argv[]) {
             // Verify result
             assert(fabs(sum - n * (7.1 + a * 0.1)) < n*TOLERANCE);
 
+            // fused daxpy and sum chunked parallel, one sweep of y
+            parallel_fill(n, 7.1, y);
+            start = std::chrono::high_resolution_clock::now();
+            sum = daxpy_sum_chunked_parallel(n, a, x, y, chunk_size);
+            end = std::chrono::high_resolution_clock::now();
+            elapsed = end - start;
+            std::cout << "\t fused daxpy + sum chunked parallel time: " << elapsed.count() << " seconds" << std::endl;
+            // Verify result
+            for (size_t j = 0; j < n; j++) {
+                assert(fabs(y[j] - (7.1 + a * 0.1)) < TOLERANCE);
+            }
+            assert(fabs(sum - n * (7.1 + a * 0.1)) < n*TOLERANCE);
+#if defined(_OPENMP)
+            // same chunks, so the same bits on a single thread
+            int threads = omp_get_max_threads();
+            omp_set_num_threads(1);
+            parallel_fill(n, 7.1, y);
+            assert(daxpy_sum_chunked_parallel(n, a, x, y, chunk_size) == sum);
+            omp_set_num_threads(threads);
+#endif
+
         }
         // parallel implementation
         // Since the y array will be modified by the previous daxpy call,
         // have to reinitialize it.
-        for (size_t j = 0; j < n; j++) {
-            y[j] = 7.1;
-        }
+        parallel_fill(n, 7.1, y);
         auto start = std::chrono::high_resolution_clock::now();
         daxpy_parallel(n, a, x, y);
         auto end = std::chrono::high_resolution_clock::now();
@@ -271,17 +382,36 @@ int main(int argc, char* argv[]) {
         for (size_t j = 0; j < n; j++) {
             assert(fabs(y[j] - (7.1 + a * 0.1)) < TOLERANCE);
         }
+
+        // bandwidth of each NUMA node, and where the pages of y are
+        parallel_fill(n, 7.1, y);
+        std::vector<NodeBandwidth> per_node = daxpy_parallel_per_node(n, a, x, y);
+        std::vector<size_t> pages = numa_pages_per_node(y, n);
+        for (size_t node = 0; node < per_node.size(); node++) {
+            if (per_node[node].threads == 0 || per_node[node].seconds <= 0.0) {
+                continue;
+            }
+            std::cout << "\t node " << node << ": " << per_node[node].threads << " thread(s), "
+                      << per_node[node].bytes / per_node[node].seconds / 1e9 << " GB/s";
+            if (!pages.empty()) {
+                std::cout << ", " << pages[node] << " sampled page(s) of y";
+            }
+            std::cout << std::endl;
+        }
+        for (size_t j = 0; j < n; j++) {
+            assert(fabs(y[j] - (7.1 + a * 0.1)) < TOLERANCE);
+        }
         // sum parallel
         start = std::chrono::high_resolution_clock::now();
-        auto sum = KahanBabushkaNeumaierSum_parallel(y, n);
+        auto sum = sum_with_parallel(sum_method, y, n);
         end = std::chrono::high_resolution_clock::now();
         elapsed = end - start;
-        std::cout << "parallel sum time: " << elapsed.count() << " seconds" << std::endl;
+        std::cout << "parallel sum (" << sum_method_name(sum_method) << ") time: " << elapsed.count() << " seconds" << std::endl;
         // Verify result
         assert(fabs(sum - n * (7.1 + a * 0.1)) < n*TOLERANCE);
 
-        delete[] x;
-        delete[] y;
+        numa_free(x);
+        numa_free(y);
         
         std::cout << "----------------------------------------" << std::endl;
     }
@@ -0,0 +1,221 @@
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef SC4PS_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+class AsyncIO {
+    /*
+    Asynchronous pread/pwrite queue
+    Requests are tagged by the caller, submitted without blocking and
+    wait() returns the tag of the next request that fully completed, in
+    whatever order the device finishes them. Up to `depth` requests are
+    in flight at once, the rest wait in a backlog.
+    On Linux with liburing the requests go through an io_uring; when
+    liburing is missing or the kernel refuses to set up a ring (old
+    kernel, seccomp) a pool of `depth` threads doing blocking
+    pread/pwrite is used instead, or straight away when use_uring is
+    false.
+    */
+public:
+    explicit AsyncIO(unsigned depth, bool use_uring = true) : depth(depth) {
+#ifdef SC4PS_HAVE_LIBURING
+        uring = use_uring && io_uring_queue_init(depth, &ring, 0) == 0;
+        if (uring)
+            return;
+#else
+        (void)use_uring;
+#endif
+        for (unsigned i = 0; i < depth; i++)
+            workers.emplace_back(&AsyncIO::worker, this);
+    }
+
+    ~AsyncIO() {
+#ifdef SC4PS_HAVE_LIBURING
+        if (uring) {
+            io_uring_queue_exit(&ring);
+            return;
+        }
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        queued.notify_all();
+        for (std::thread &t: workers)
+            t.join();
+    }
+
+    AsyncIO(const AsyncIO &) = delete;
+    AsyncIO &operator=(const AsyncIO &) = delete;
+
+    const char *backend() const { return uring ? "io_uring" : "thread pool"; }
+
+    void submit_read(int fd, void *buf, size_t len, off_t offset, uint64_t tag) {
+        submit({fd, static_cast<char*>(buf), len, offset, false, tag});
+    }
+
+    void submit_write(int fd, const void *buf, size_t len, off_t offset, uint64_t tag) {
+        submit({fd, static_cast<char*>(const_cast<void*>(buf)), len, offset, true, tag});
+    }
+
+    uint64_t wait() {
+#ifdef SC4PS_HAVE_LIBURING
+        if (uring)
+            return wait_uring();
+#endif
+        std::unique_lock<std::mutex> lock(mutex);
+        completed.wait(lock, [this] { return !done.empty(); });
+        Request req = done.front();
+        done.pop_front();
+        if (req.len != 0)
+            fail(req);
+        return req.tag;
+    }
+
+private:
+    struct Request {
+        int fd;
+        char *buf;
+        size_t len;    // bytes still to transfer, 0 once done
+        off_t offset;
+        bool write;
+        uint64_t tag;
+    };
+
+    static void fail(const Request &req) {
+        std::cerr << "Error: asynchronous " << (req.write ? "write" : "read") << " failed at offset "
+                  << req.offset << " (" << req.len << " bytes left)\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    void submit(const Request &req) {
+#ifdef SC4PS_HAVE_LIBURING
+        if (uring) {
+            backlog.push_back(req);
+            pump_uring();
+            return;
+        }
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            backlog.push_back(req);
+        }
+        queued.notify_one();
+    }
+
+    void worker() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            queued.wait(lock, [this] { return stopping || !backlog.empty(); });
+            if (backlog.empty())
+                return;
+            Request req = backlog.front();
+            backlog.pop_front();
+            lock.unlock();
+
+            // Blocking transfer, restarted on short reads and writes
+            while (req.len > 0) {
+                ssize_t n = req.write ? pwrite(req.fd, req.buf, req.len, req.offset)
+                                      : pread(req.fd, req.buf, req.len, req.offset);
+                if (n <= 0)
+                    break;
+                req.buf += n;
+                req.len -= n;
+                req.offset += n;
+            }
+
+            lock.lock();
+            done.push_back(req);
+            completed.notify_one();
+        }
+    }
+
+#ifdef SC4PS_HAVE_LIBURING
+    void pump_uring() {
+        // Move as much of the backlog to the ring as it has room for
+        bool any = false;
+        while (!backlog.empty() && inflight.size() < depth) {
+            io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+            if (sqe == nullptr)
+                break;
+            Request *req = new Request(backlog.front());
+            backlog.pop_front();
+            if (req->write)
+                io_uring_prep_write(sqe, req->fd, req->buf, req->len, req->offset);
+            else
+                io_uring_prep_read(sqe, req->fd, req->buf, req->len, req->offset);
+            io_uring_sqe_set_data(sqe, req);
+            inflight.push_back(req);
+            any = true;
+        }
+        if (any && io_uring_submit(&ring) < 0) {
+            std::cerr << "Error: io_uring_submit failed\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t wait_uring() {
+        while (true) {
+            io_uring_cqe *cqe;
+            if (io_uring_wait_cqe(&ring, &cqe) < 0) {
+                std::cerr << "Error: io_uring_wait_cqe failed\n";
+                std::exit(EXIT_FAILURE);
+            }
+            Request *req = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+            int res = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+            for (size_t i = 0; i < inflight.size(); i++) {
+                if (inflight[i] == req) {
+                    inflight[i] = inflight.back();
+                    inflight.pop_back();
+                    break;
+                }
+            }
+
+            Request r = *req;
+            delete req;
+            if (res <= 0)
+                fail(r);
+            r.buf += res;
+            r.len -= res;
+            r.offset += res;
+            if (r.len > 0) {
+                // Short transfer, queue the rest in front of the backlog
+                backlog.push_front(r);
+                pump_uring();
+                continue;
+            }
+            pump_uring();
+            return r.tag;
+        }
+    }
+
+    io_uring ring;
+    std::vector<Request*> inflight;
+#endif
+
+    unsigned depth;
+    bool uring = false;
+
+    std::mutex mutex;
+    std::condition_variable queued, completed;
+    std::deque<Request> backlog, done;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+#endif //ASYNC_IO_HPP
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "sum.hpp"
+#include "sum_kernels.hpp"
+
+// Bin b holds multiples of ulp(b) = 2^(b * BINNED_WIDTH - 1074): bin 0 is
+// the ulp of the subnormals, bin 51 the highest whose primary does not
+// overflow, for values below 2^1004. Values go to the bins from the
+// first one with |x| < 2^(BINNED_WIDTH - 2) ulp(b): the bins above get
+// nothing from them, which is what makes the state independent of the
+// order.
+static const double BINNED_LIMIT = 0x1p1004;
+// deposits of at most 2^(BINNED_WIDTH - 1) ulp each into a primary kept
+// within 2^49 ulp of its base stay within 2^50 ulp, i.e. in range
+static const int BINNED_RENORM = 1024;
+// bins that do not exist (index < 0) only ever see 0.0
+static const double BINNED_DUMMY = 1.5;
+
+static double bin_base(int b) {
+    // 1.5 * 2^52 ulp: the primary of an empty bin
+    return b < 0 ? BINNED_DUMMY : 1.5 * std::ldexp(1.0, b * BINNED_WIDTH - 1022);
+}
+
+static double bin_carry_unit(int b) {
+    return std::ldexp(1.0, b * BINNED_WIDTH - 1024);
+}
+
+static int bin_of(double amax) {
+    // first bin with amax < 2^(BINNED_WIDTH - 2) ulp(b), amax < 2^1004
+    uint64_t bits;
+    std::memcpy(&bits, &amax, sizeof(bits));
+    int e = (int)((bits >> 52) & 0x7ff) - 1022; // amax < 2^e
+    if (e == -1022) {
+        std::frexp(amax, &e); // subnormal
+    }
+    return (e + 1074 - (BINNED_WIDTH - 2) + BINNED_WIDTH - 1) / BINNED_WIDTH;
+}
+
+static void renormalize(BinnedSum &s, int k) {
+    // moves whole multiples of 2^50 ulp from the primary to the carry,
+    // leaving primary - base in [-2^49, 2^49) ulp: a bin has only one
+    // such representation, so equal states round to the same value
+    int b = s.top - k;
+    if (b < 0) {
+        return;
+    }
+    double unit = bin_carry_unit(b);
+    double m = std::floor((s.primary[k] - bin_base(b)) / unit + 0.5);
+    s.primary[k] -= m * unit;
+    s.carry[k] += m;
+}
+
+static void raise_top(BinnedSum &s, int top) {
+    // makes top the highest bin, dropping the bins that fall off the end
+    if (top <= s.top) {
+        return;
+    }
+    int shift = top - s.top;
+    for (int k = BINNED_FOLD - 1; k >= 0; k--) {
+        if (k >= shift) {
+            s.primary[k] = s.primary[k - shift];
+            s.carry[k] = s.carry[k - shift];
+        } else {
+            s.primary[k] = bin_base(top - k);
+            s.carry[k] = 0.0;
+        }
+    }
+    s.top = top;
+}
+
+static void renormalize_all(BinnedSum &s) {
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        renormalize(s, k);
+    }
+    s.deposits = 0;
+}
+
+static binned_deposit_t binned_kernel(Isa isa) {
+    switch (isa) {
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return binned_deposit_avx2;
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return binned_deposit_avx512;
+#endif
+    default:
+        return binned_deposit_generic;
+    }
+}
+
+static inline double or_bits(double d, uint64_t mask) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    bits |= mask;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+void binned_deposit_generic(double (*primary)[BINNED_LANES], const uint64_t *lsb, const double *vec, int n) {
+    for (int i = 0; i < n; i += BINNED_LANES) {
+        for (int j = 0; j < BINNED_LANES; j++) {
+            double r = vec[i + j];
+            for (int k = 0; k < BINNED_FOLD - 1; k++) {
+                double q = primary[k][j] + or_bits(r, lsb[k]);
+                r -= q - primary[k][j];
+                primary[k][j] = q;
+            }
+            // the rest, below the last bin, is dropped
+            primary[BINNED_FOLD - 1][j] += or_bits(r, lsb[BINNED_FOLD - 1]);
+        }
+    }
+}
+
+static void deposit_one(BinnedSum &s, double x) {
+    // the scalar version of the kernels, straight into the state
+    raise_top(s, bin_of(std::fabs(x)));
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        int b = s.top - k;
+        if (b < 0) {
+            break;
+        }
+        double q = s.primary[k] + or_bits(x, b > 0 ? 1 : 0);
+        x -= q - s.primary[k];
+        s.primary[k] = q;
+    }
+    if (++s.deposits == BINNED_RENORM) {
+        renormalize_all(s);
+    }
+}
+
+void binned_sum_clear(BinnedSum &s) {
+    s.top = -1;
+    s.deposits = 0;
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        s.primary[k] = BINNED_DUMMY;
+        s.carry[k] = 0.0;
+    }
+    s.special = 0.0;
+}
+
+static void add_lanes(BinnedSum &s, const double *vec, int n) {
+    /*
+    n <= BINNED_RENORM * BINNED_LANES finite values below BINNED_LIMIT,
+    s.top already high enough for all of them. The tail that does not
+    fill the lanes is padded with zeros, which deposit nothing.
+    */
+    static const binned_deposit_t kernel = binned_kernel(sum_selected_isa());
+
+    double primary[BINNED_FOLD][BINNED_LANES];
+    uint64_t lsb[BINNED_FOLD];
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        int b = s.top - k;
+        lsb[k] = b > 0 ? 1 : 0;
+        for (int j = 0; j < BINNED_LANES; j++) {
+            primary[k][j] = bin_base(b);
+        }
+    }
+
+    renormalize_all(s);
+    int full = n - n % BINNED_LANES;
+    kernel(primary, lsb, vec, full);
+    if (full < n) {
+        double tail[BINNED_LANES] = {0.0};
+        std::copy(vec + full, vec + n, tail);
+        kernel(primary, lsb, tail, BINNED_LANES);
+    }
+
+    // fold the lanes in, renormalizing after each one to stay in range
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        int b = s.top - k;
+        if (b < 0) {
+            continue;
+        }
+        for (int j = 0; j < BINNED_LANES; j++) {
+            s.primary[k] += primary[k][j] - bin_base(b);
+            renormalize(s, k);
+        }
+    }
+}
+
+void binned_sum_add(BinnedSum &s, const double *vec, int n) {
+    const int block = BINNED_RENORM * BINNED_LANES;
+
+    if (n < 8 * BINNED_LANES) {
+        // short runs (small chunks), not worth setting the lanes up
+        for (int i = 0; i < n; i++) {
+            if (std::fabs(vec[i]) < BINNED_LIMIT) {
+                if (vec[i] != 0.0) {
+                    deposit_one(s, vec[i]);
+                }
+            } else {
+                s.special += vec[i];
+            }
+        }
+        return;
+    }
+
+    for (int start = 0; start < n; start += block) {
+        const double *v = vec + start;
+        int len = std::min(block, n - start);
+
+        // x * 0 is 0 unless x is inf or nan
+        double amax = 0.0, probe = 0.0;
+        for (int i = 0; i < len; i++) {
+            amax = std::max(amax, std::fabs(v[i]));
+            probe += v[i] * 0.0;
+        }
+
+        if (probe == 0.0 && amax < BINNED_LIMIT) {
+            if (amax > 0.0) {
+                raise_top(s, bin_of(amax));
+                add_lanes(s, v, len);
+            }
+            continue;
+        }
+
+        // rare: set the special values aside, one at a time
+        for (int i = 0; i < len; i++) {
+            if (std::fabs(v[i]) < BINNED_LIMIT) {
+                if (v[i] != 0.0) {
+                    deposit_one(s, v[i]);
+                }
+            } else {
+                s.special += v[i];
+            }
+        }
+    }
+}
+
+void binned_sum_merge(BinnedSum &a, const BinnedSum &b_in) {
+    BinnedSum b = b_in;
+    a.special += b.special;
+    if (b.top < 0) {
+        return;
+    }
+    renormalize_all(a);
+    renormalize_all(b);
+    raise_top(a, b.top);
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        int bin = a.top - k;
+        int kb = b.top - bin;
+        if (bin < 0 || kb < 0 || kb >= BINNED_FOLD) {
+            continue;
+        }
+        a.primary[k] += b.primary[kb] - bin_base(bin);
+        a.carry[k] += b.carry[kb];
+        renormalize(a, k);
+    }
+}
+
+double binned_sum_value(const BinnedSum &s_in) {
+    /*
+    Every bin is exactly (primary - base) + carry * 2^50 ulp, two
+    doubles, in a unique form once renormalized; they are added from the
+    top bin down with KBN, a fixed sequence of operations on the bins.
+    */
+    BinnedSum s = s_in;
+    renormalize_all(s);
+    CompensatedSum acc = {0.0, 0.0};
+    for (int k = 0; k < BINNED_FOLD; k++) {
+        int b = s.top - k;
+        if (b < 0) {
+            break;
+        }
+        compensated_add(acc, s.carry[k] * bin_carry_unit(b));
+        compensated_add(acc, s.primary[k] - bin_base(b));
+    }
+    return (acc.sum + acc.c) + s.special;
+}
+
+double ReproducibleSum(const double *vec, int n) {
+    BinnedSum s;
+    binned_sum_clear(s);
+    binned_sum_add(s, vec, n);
+    return binned_sum_value(s);
+}
+
+double ReproducibleSum_parallel(const double *vec, int n) {
+    const int block = BINNED_RENORM * BINNED_LANES;
+    const int blocks = (n + block - 1) / block;
+
+    BinnedSum s;
+    binned_sum_clear(s);
+
+    #pragma omp parallel for schedule(static) reduction(binned_merge: s)
+    for (int b = 0; b < blocks; b++) {
+        int start = b * block;
+        binned_sum_add(s, vec + start, std::min(block, n - start));
+    }
+    return binned_sum_value(s);
+}
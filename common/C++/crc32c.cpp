@@ -0,0 +1,42 @@
+#include "crc32c.hpp"
+
+// Internal: see crc32c_sse42.cpp, only call it on a CPU with SSE4.2
+uint32_t crc32c_sse42(uint32_t crc, const void *data, size_t len);
+
+// 256-entry table of the byte-at-a-time algorithm
+struct Crc32cTable {
+    uint32_t entry[256];
+
+    Crc32cTable() {
+        // reflected Castagnoli polynomial
+        const uint32_t POLY = 0x82f63b78;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (c >> 1) ^ POLY : c >> 1;
+            }
+            entry[i] = c;
+        }
+    }
+};
+
+uint32_t crc32c_scalar(uint32_t crc, const void *data, size_t len) {
+    static const Crc32cTable table;
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table.entry[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+#if defined(SC4PS_HAVE_SSE42)
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    if (hardware) {
+        return crc32c_sse42(crc, data, len);
+    }
+#endif
+    return crc32c_scalar(crc, data, len);
+}
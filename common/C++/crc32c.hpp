@@ -0,0 +1,16 @@
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32C (Castagnoli polynomial, as in iSCSI, ext4 and SSE4.2) of len
+// bytes, continuing from crc: start with 0, and
+// crc32c(crc32c(0, a, n), b, m) is the CRC of a followed by b.
+// Uses the SSE4.2 crc32 instruction when the CPU has it.
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+// Table-driven reference, byte at a time
+uint32_t crc32c_scalar(uint32_t crc, const void *data, size_t len);
+
+#endif // CRC32C_HPP
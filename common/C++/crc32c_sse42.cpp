@@ -0,0 +1,90 @@
+#include <cstring>
+
+#include <nmmintrin.h>
+
+#include "crc32c.hpp"
+
+uint32_t crc32c_sse42(uint32_t crc, const void *data, size_t len);
+
+// crc32 has a latency of 3 cycles and a throughput of 1 per cycle: one
+// chain of them runs at a third of the speed of the unit. Long inputs
+// are cut in blocks of 3 streams, crc'ed side by side and combined.
+static const size_t CRC_LONG = 8192; // bytes per stream
+static const size_t CRC_SHORT = 256;
+// reflected Castagnoli polynomial
+static const uint32_t CRC_POLY = 0x82f63b78;
+
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+    // a * b modulo the polynomial, bit 31 is x^0 (a != 0)
+    uint32_t m = 1u << 31, p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC_POLY : b >> 1;
+    }
+    return p;
+}
+
+static uint32_t zeros_operator(size_t len) {
+    // x^(8 len): the crc register of x^0 after len zero bytes
+    uint64_t c = 1u << 31;
+    for (size_t i = 0; i < len; i += 8) {
+        c = _mm_crc32_u64(c, 0);
+    }
+    return uint32_t(c);
+}
+
+static uint64_t crc_streams(uint64_t c, const unsigned char *&p, size_t &len, size_t block, uint32_t shift) {
+    /*
+    The register after a block B from c is x^(8 |B|) c + crc(0, B): the
+    second and third streams start from 0 and are added in after
+    shifting what comes before them over their length.
+    */
+    while (len >= 3 * block) {
+        uint64_t c1 = 0, c2 = 0;
+        const unsigned char *end = p + block;
+        for (; p < end; p += 8) {
+            uint64_t w0, w1, w2;
+            std::memcpy(&w0, p, 8);
+            std::memcpy(&w1, p + block, 8);
+            std::memcpy(&w2, p + 2 * block, 8);
+            c = _mm_crc32_u64(c, w0);
+            c1 = _mm_crc32_u64(c1, w1);
+            c2 = _mm_crc32_u64(c2, w2);
+        }
+        c = multmodp(shift, uint32_t(c)) ^ c1;
+        c = multmodp(shift, uint32_t(c)) ^ c2;
+        p += 2 * block;
+        len -= 3 * block;
+    }
+    return c;
+}
+
+// 8 bytes per crc32 instruction, 3 streams at a time, bytes before and after
+uint32_t crc32c_sse42(uint32_t crc, const void *data, size_t len) {
+    static const uint32_t shift_long = zeros_operator(CRC_LONG);
+    static const uint32_t shift_short = zeros_operator(CRC_SHORT);
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    uint64_t c = ~crc;
+
+    // align the pointer so the 8-byte loads do not split cache lines
+    for (; len > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0; len--, p++) {
+        c = _mm_crc32_u8(uint32_t(c), *p);
+    }
+    c = crc_streams(c, p, len, CRC_LONG, shift_long);
+    c = crc_streams(c, p, len, CRC_SHORT, shift_short);
+    for (; len >= 8; len -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+    }
+    for (; len > 0; len--, p++) {
+        c = _mm_crc32_u8(uint32_t(c), *p);
+    }
+    return ~uint32_t(c);
+}
@@ -0,0 +1,59 @@
+#include "daxpy.hpp"
+#include "daxpy_kernels.hpp"
+
+void daxpy_unrolled(int n, double a, const double *x, double *y) {
+
+    if (n <= 0 || a == 0.0) {
+        return;
+    }
+
+    int m = n % 4;
+    for (int i = 0; i < m; i++) {
+        y[i] += a * x[i];
+    }
+
+    for (int i = m; i < n; i += 4) {
+        y[i] += a * x[i];
+        y[i + 1] += a * x[i + 1];
+        y[i + 2] += a * x[i + 2];
+        y[i + 3] += a * x[i + 3];
+    }
+}
+
+daxpy_kernel_t daxpy_kernel(Isa isa) {
+    if (!isa_supported(isa)) {
+        return nullptr;
+    }
+
+    switch (isa) {
+#if defined(SC4PS_HAVE_SSE2)
+    case Isa::SSE2:
+        return daxpy_sse2;
+#endif
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return daxpy_avx2;
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return daxpy_avx512;
+#endif
+    default:
+        return daxpy_unrolled;
+    }
+}
+
+Isa daxpy_selected_isa() {
+    // resolved once, on first use (thread-safe static initialization)
+    static const Isa isa = isa_select("SC4PS_DAXPY_ISA");
+    return isa;
+}
+
+void daxpy(int n, double a, const double *x, double *y) {
+    static const daxpy_kernel_t kernel = daxpy_kernel(daxpy_selected_isa());
+
+    if (n <= 0 || a == 0.0) {
+        return;
+    }
+    kernel(n, a, x, y);
+}
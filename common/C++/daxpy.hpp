@@ -0,0 +1,27 @@
+#ifndef DAXPY_HPP
+#define DAXPY_HPP
+
+#include "isa.hpp"
+
+// Shared daxpy kernels, y = a*x + y.
+// The widest implementation supported by the host (AVX-512, AVX2, SSE2
+// or plain scalar) is picked once at runtime via CPUID, so the same
+// binary runs on every node without being rebuilt.
+// All implementations use a separate multiply and add (no FMA), hence
+// results are bit-identical whichever kernel gets selected.
+
+typedef void (*daxpy_kernel_t)(int n, double a, const double *x, double *y);
+
+// y = a*x + y with the best kernel for this host
+void daxpy(int n, double a, const double *x, double *y);
+
+// portable 4-way unrolled scalar kernel, kept as a reference
+void daxpy_unrolled(int n, double a, const double *x, double *y);
+
+// Introspection, mostly for benchmarks and tests.
+// The selection can be forced with the environment variable
+// SC4PS_DAXPY_ISA=scalar|sse2|avx2|avx512 (ignored if unsupported).
+Isa daxpy_selected_isa();
+daxpy_kernel_t daxpy_kernel(Isa isa); // nullptr if not supported
+
+#endif // DAXPY_HPP
@@ -0,0 +1,34 @@
+#include <immintrin.h>
+
+#include "daxpy_kernels.hpp"
+
+// 4 doubles per register, 4 registers per iteration
+void daxpy_avx2(int n, double a, const double *x, double *y) {
+    const __m256d va = _mm256_set1_pd(a);
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d y0 = _mm256_loadu_pd(y + i);
+        __m256d y1 = _mm256_loadu_pd(y + i + 4);
+        __m256d y2 = _mm256_loadu_pd(y + i + 8);
+        __m256d y3 = _mm256_loadu_pd(y + i + 12);
+        y0 = _mm256_add_pd(y0, _mm256_mul_pd(va, _mm256_loadu_pd(x + i)));
+        y1 = _mm256_add_pd(y1, _mm256_mul_pd(va, _mm256_loadu_pd(x + i + 4)));
+        y2 = _mm256_add_pd(y2, _mm256_mul_pd(va, _mm256_loadu_pd(x + i + 8)));
+        y3 = _mm256_add_pd(y3, _mm256_mul_pd(va, _mm256_loadu_pd(x + i + 12)));
+        _mm256_storeu_pd(y + i, y0);
+        _mm256_storeu_pd(y + i + 4, y1);
+        _mm256_storeu_pd(y + i + 8, y2);
+        _mm256_storeu_pd(y + i + 12, y3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d y0 = _mm256_loadu_pd(y + i);
+        y0 = _mm256_add_pd(y0, _mm256_mul_pd(va, _mm256_loadu_pd(x + i)));
+        _mm256_storeu_pd(y + i, y0);
+    }
+
+    // remainder
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
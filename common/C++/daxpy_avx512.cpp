@@ -0,0 +1,38 @@
+#include <immintrin.h>
+
+#include "daxpy_kernels.hpp"
+
+// 8 doubles per register, 4 registers per iteration,
+// the tail is handled with a masked load/store
+void daxpy_avx512(int n, double a, const double *x, double *y) {
+    const __m512d va = _mm512_set1_pd(a);
+
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512d y0 = _mm512_loadu_pd(y + i);
+        __m512d y1 = _mm512_loadu_pd(y + i + 8);
+        __m512d y2 = _mm512_loadu_pd(y + i + 16);
+        __m512d y3 = _mm512_loadu_pd(y + i + 24);
+        y0 = _mm512_add_pd(y0, _mm512_mul_pd(va, _mm512_loadu_pd(x + i)));
+        y1 = _mm512_add_pd(y1, _mm512_mul_pd(va, _mm512_loadu_pd(x + i + 8)));
+        y2 = _mm512_add_pd(y2, _mm512_mul_pd(va, _mm512_loadu_pd(x + i + 16)));
+        y3 = _mm512_add_pd(y3, _mm512_mul_pd(va, _mm512_loadu_pd(x + i + 24)));
+        _mm512_storeu_pd(y + i, y0);
+        _mm512_storeu_pd(y + i + 8, y1);
+        _mm512_storeu_pd(y + i + 16, y2);
+        _mm512_storeu_pd(y + i + 24, y3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m512d y0 = _mm512_loadu_pd(y + i);
+        y0 = _mm512_add_pd(y0, _mm512_mul_pd(va, _mm512_loadu_pd(x + i)));
+        _mm512_storeu_pd(y + i, y0);
+    }
+
+    // remainder
+    if (i < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - i)) - 1u);
+        __m512d y0 = _mm512_maskz_loadu_pd(mask, y + i);
+        y0 = _mm512_add_pd(y0, _mm512_mul_pd(va, _mm512_maskz_loadu_pd(mask, x + i)));
+        _mm512_mask_storeu_pd(y + i, mask, y0);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef DAXPY_KERNELS_HPP
+#define DAXPY_KERNELS_HPP
+
+// Internal: ISA-specific kernels, each one lives in its own translation
+// unit compiled with the matching -m flags. Only call them after checking
+// the CPU supports the instruction set (see daxpy.cpp).
+
+void daxpy_sse2(int n, double a, const double *x, double *y);
+void daxpy_avx2(int n, double a, const double *x, double *y);
+void daxpy_avx512(int n, double a, const double *x, double *y);
+
+#endif // DAXPY_KERNELS_HPP
@@ -0,0 +1,23 @@
+#include <emmintrin.h>
+
+#include "daxpy_kernels.hpp"
+
+// 2 doubles per register, 2 registers per iteration
+void daxpy_sse2(int n, double a, const double *x, double *y) {
+    const __m128d va = _mm_set1_pd(a);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128d y0 = _mm_loadu_pd(y + i);
+        __m128d y1 = _mm_loadu_pd(y + i + 2);
+        y0 = _mm_add_pd(y0, _mm_mul_pd(va, _mm_loadu_pd(x + i)));
+        y1 = _mm_add_pd(y1, _mm_mul_pd(va, _mm_loadu_pd(x + i + 2)));
+        _mm_storeu_pd(y + i, y0);
+        _mm_storeu_pd(y + i + 2, y1);
+    }
+
+    // remainder
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+
+#include "daxpy_sum.hpp"
+#include "sum_kernels.hpp"
+
+void daxpy_reduction_clear(DaxpyReduction &r) {
+    r.sum = {0.0, 0.0};
+    r.sum_sq = {0.0, 0.0};
+    r.min = INFINITY;
+    r.max = -INFINITY;
+}
+
+void daxpy_reduction_merge(DaxpyReduction &a, const DaxpyReduction &b) {
+    a.sum = compensated_merge(a.sum, b.sum);
+    a.sum_sq = compensated_merge(a.sum_sq, b.sum_sq);
+    a.min = std::min(a.min, b.min);
+    a.max = std::max(a.max, b.max);
+}
+
+template <bool STATS>
+static DaxpyReduction daxpy_reduce_scalar(int n, double a, const double *x, double *y) {
+    // one (sum, c) pair in order, as KahanBabushkaNeumaierSum_scalar
+    const bool axpy = a != 0.0;
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    for (int i = 0; i < n; i++) {
+        if (axpy) {
+            y[i] += a * x[i];
+        }
+        compensated_add(r.sum, y[i]);
+        if (STATS) {
+            compensated_add(r.sum_sq, y[i] * y[i]);
+            r.min = std::min(r.min, y[i]);
+            r.max = std::max(r.max, y[i]);
+        }
+    }
+    return r;
+}
+
+static CompensatedSum daxpy_sum_scalar(int n, double a, const double *x, double *y) {
+    return daxpy_reduce_scalar<false>(n, a, x, y).sum;
+}
+
+daxpy_sum_kernel_t daxpy_sum_kernel(Isa isa) {
+    if (!isa_supported(isa)) {
+        return nullptr;
+    }
+
+    switch (isa) {
+#if defined(SC4PS_HAVE_SSE2)
+    case Isa::SSE2:
+        return daxpy_sum_sse2;
+#endif
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return daxpy_sum_avx2;
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return daxpy_sum_avx512;
+#endif
+    default:
+        return daxpy_sum_scalar;
+    }
+}
+
+daxpy_reduce_kernel_t daxpy_reduce_kernel(Isa isa) {
+    if (!isa_supported(isa)) {
+        return nullptr;
+    }
+
+    switch (isa) {
+#if defined(SC4PS_HAVE_SSE2)
+    case Isa::SSE2:
+        return daxpy_reduce_sse2;
+#endif
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return daxpy_reduce_avx2;
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return daxpy_reduce_avx512;
+#endif
+    default:
+        return daxpy_reduce_scalar<true>;
+    }
+}
+
+CompensatedSum daxpy_sum_partial(int n, double a, const double *x, double *y) {
+    static const daxpy_sum_kernel_t kernel = daxpy_sum_kernel(sum_selected_isa());
+
+    if (n <= 0) {
+        return {0.0, 0.0};
+    }
+    if (a == 0.0) {
+        // y is left alone, as by daxpy
+        return KahanBabushkaNeumaierSum_partial(y, n);
+    }
+    return kernel(n, a, x, y);
+}
+
+double daxpy_sum(int n, double a, const double *x, double *y) {
+    CompensatedSum s = daxpy_sum_partial(n, a, x, y);
+    return s.sum + s.c;
+}
+
+void daxpy_reduce(int n, double a, const double *x, double *y, DaxpyReduction &r) {
+    static const daxpy_reduce_kernel_t kernel = daxpy_reduce_kernel(sum_selected_isa());
+
+    if (n <= 0) {
+        return;
+    }
+    // the kernels do not write y when a is 0
+    daxpy_reduction_merge(r, kernel(n, a, x, y));
+}
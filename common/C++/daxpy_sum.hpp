@@ -0,0 +1,50 @@
+#ifndef DAXPY_SUM_HPP
+#define DAXPY_SUM_HPP
+
+#include "isa.hpp"
+#include "sum.hpp"
+
+// Fused daxpy and reduction: y = a*x + y and the compensated sum of the
+// new y in the same sweep, instead of daxpy followed by a sum that reads
+// y back from memory. Both are bandwidth bound, the fused kernel moves
+// 3 doubles per element instead of 4.
+// The kernels do the same operations in the same order as daxpy and then
+// KahanBabushkaNeumaierSum_partial on the same ISA, so y and the sum are
+// bit-identical to the two separate calls.
+
+// y = a*x + y, returns the KBN sum of the updated y (unrounded, so that
+// partial sums of chunks, threads or ranks can be merged)
+CompensatedSum daxpy_sum_partial(int n, double a, const double *x, double *y);
+double daxpy_sum(int n, double a, const double *x, double *y);
+
+// The sum with the sum of squares, the minimum and the maximum of the
+// updated y, e.g. for a mean and a standard deviation in one pass
+// (for data far from 0, prefer the Moments of moments.hpp).
+struct DaxpyReduction {
+    CompensatedSum sum;
+    CompensatedSum sum_sq;
+    double min;             // +inf and -inf when empty
+    double max;
+};
+
+void daxpy_reduction_clear(DaxpyReduction &r);
+// a += b
+void daxpy_reduction_merge(DaxpyReduction &a, const DaxpyReduction &b);
+
+#ifdef _OPENMP
+#pragma omp declare reduction(daxpy_reduction_merge : DaxpyReduction : daxpy_reduction_merge(omp_out, omp_in)) \
+    initializer(daxpy_reduction_clear(omp_priv))
+#endif
+
+// y = a*x + y, the reduction of the updated y is merged into r
+void daxpy_reduce(int n, double a, const double *x, double *y, DaxpyReduction &r);
+
+typedef CompensatedSum (*daxpy_sum_kernel_t)(int n, double a, const double *x, double *y);
+typedef DaxpyReduction (*daxpy_reduce_kernel_t)(int n, double a, const double *x, double *y);
+
+// Introspection, mostly for benchmarks and tests. The kernels follow the
+// sum kernels: see sum_selected_isa (SC4PS_SUM_ISA).
+daxpy_sum_kernel_t daxpy_sum_kernel(Isa isa); // nullptr if not supported
+daxpy_reduce_kernel_t daxpy_reduce_kernel(Isa isa);
+
+#endif // DAXPY_SUM_HPP
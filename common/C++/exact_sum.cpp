@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "sum.hpp"
+
+// Limb i holds multiples of 2^(32 i - 1074). A double is m * 2^(p - 1074)
+// with m < 2^53 and p <= 2045, so it lands in limbs p / 32 to p / 32 + 2,
+// at most limb 65; the limbs above take the carries.
+static const int64_t LIMB_MASK = 0xffffffff;
+// every addition moves a limb by less than 2^32: normalized limbs
+// (below 2^32) can take 2^30 of them and stay far from overflowing
+static const int SUPERACC_BLOCK = 1 << 20;
+
+static void normalize(SuperAccumulator &s) {
+    // every limb but the top one in [0, 2^32), the top one holds the sign
+    for (int i = 0; i < SUPERACC_LIMBS - 1; i++) {
+        int64_t carry = s.limb[i] >> 32; // floor division
+        s.limb[i] -= carry * (LIMB_MASK + 1);
+        s.limb[i + 1] += carry;
+    }
+    s.adds = 0;
+}
+
+void superacc_clear(SuperAccumulator &s) {
+    for (int i = 0; i < SUPERACC_LIMBS; i++) {
+        s.limb[i] = 0;
+    }
+    s.special = 0.0;
+    s.adds = 0;
+}
+
+void superacc_add(SuperAccumulator &s, const double *vec, int n) {
+    for (int start = 0; start < n; start += SUPERACC_BLOCK) {
+        int len = std::min(SUPERACC_BLOCK, n - start);
+        if (s.adds + len > SUPERACC_BLOCK) {
+            normalize(s);
+        }
+        s.adds += len;
+
+        for (int i = start; i < start + len; i++) {
+            uint64_t bits;
+            std::memcpy(&bits, &vec[i], sizeof(bits));
+            int biased = (bits >> 52) & 0x7ff;
+            if (biased == 0x7ff) {
+                // inf and nan, they have no place in the limbs
+                s.special += vec[i];
+                continue;
+            }
+
+            // mantissa and position of its lowest bit, subnormals included
+            uint64_t m = bits & ((1ull << 52) - 1);
+            int pos = 0;
+            if (biased > 0) {
+                m |= 1ull << 52;
+                pos = biased - 1;
+            }
+            int limb = pos >> 5, shift = pos & 31;
+            int64_t lo = (m << shift) & LIMB_MASK;
+            uint64_t rest = m >> (32 - shift);
+            int64_t mid = rest & LIMB_MASK;
+            int64_t hi = rest >> 32;
+
+            // branch-free negation for negative values
+            int64_t sign = -(int64_t)(bits >> 63);
+            s.limb[limb] += (lo ^ sign) - sign;
+            s.limb[limb + 1] += (mid ^ sign) - sign;
+            s.limb[limb + 2] += (hi ^ sign) - sign;
+        }
+    }
+}
+
+void superacc_merge(SuperAccumulator &a, const SuperAccumulator &b_in) {
+    SuperAccumulator b = b_in;
+    normalize(a);
+    normalize(b);
+    for (int i = 0; i < SUPERACC_LIMBS; i++) {
+        a.limb[i] += b.limb[i];
+    }
+    a.special += b.special;
+    normalize(a);
+}
+
+double superacc_value(const SuperAccumulator &s_in) {
+    /*
+    Rounds the fixed-point number to the nearest double (ties to even):
+    the top 64 significant bits go through one integer to double
+    conversion, which rounds correctly, with the bits below folded into
+    a sticky bit so that ties are only seen when they are real. Below
+    2^-1022 the sum is a multiple of 2^-1074 that fits a double exactly.
+    */
+    if (s_in.special != 0.0) {
+        return s_in.special;
+    }
+    SuperAccumulator s = s_in;
+    normalize(s);
+
+    bool negative = s.limb[SUPERACC_LIMBS - 1] < 0;
+    if (negative) {
+        for (int i = 0; i < SUPERACC_LIMBS; i++) {
+            s.limb[i] = -s.limb[i];
+        }
+        normalize(s);
+    }
+
+    int h = SUPERACC_LIMBS - 1;
+    while (h >= 0 && s.limb[h] == 0) {
+        h--;
+    }
+    if (h < 0) {
+        return 0.0;
+    }
+    // leading bit, at 2^lead_exp
+    int lead_bit = 63 - __builtin_clzll((uint64_t)s.limb[h]);
+    int lead_exp = 32 * h - 1074 + lead_bit;
+    if (lead_exp >= 1024) {
+        return negative ? -INFINITY : INFINITY;
+    }
+    if (lead_exp < -1022) {
+        // subnormal range, only limbs 0 and 1 are used
+        uint64_t small = ((uint64_t)s.limb[1] << 32) | (uint64_t)s.limb[0];
+        double d = std::ldexp((double)small, -1074);
+        return negative ? -d : d;
+    }
+
+    // the (up to) 3 highest limbs, shifted so that the leading bit is
+    // bit 127: its top 64 bits are rounded, the rest is sticky
+    int loaded = std::min(h, 2) + 1;
+    unsigned __int128 acc = 0;
+    for (int i = h; i > h - loaded; i--) {
+        acc = (acc << 32) | (uint64_t)s.limb[i];
+    }
+    int shift = 127 - (32 * (loaded - 1) + lead_bit);
+    acc <<= shift;
+    uint64_t top = (uint64_t)(acc >> 64);
+    bool sticky = (uint64_t)acc != 0;
+    for (int i = h - loaded; i >= 0 && !sticky; i--) {
+        sticky = s.limb[i] != 0;
+    }
+    int exponent = lead_exp - 63; // of the last bit of top
+    double d = std::ldexp((double)(top | (sticky ? 1 : 0)), exponent);
+    return negative ? -d : d;
+}
+
+double ExactSum(const double *vec, int n) {
+    SuperAccumulator s;
+    superacc_clear(s);
+    superacc_add(s, vec, n);
+    return superacc_value(s);
+}
+
+double ExactSum_parallel(const double *vec, int n) {
+    const int block = 1 << 16;
+    const int blocks = (n + block - 1) / block;
+
+    SuperAccumulator s;
+    superacc_clear(s);
+
+    #pragma omp parallel for schedule(static) reduction(superacc_merge: s)
+    for (int b = 0; b < blocks; b++) {
+        int start = b * block;
+        superacc_add(s, vec + start, std::min(block, n - start));
+    }
+    return superacc_value(s);
+}
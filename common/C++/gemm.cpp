@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "gemm.hpp"
+#include "gemm_kernels.hpp"
+
+// Cache blocking. MC is a multiple of every MR and NC of every NR, so
+// only the blocks at the matrix edges are ragged.
+// A block: MC x KC doubles = 192 KiB (L2), B slab: KC x NC = 4 MiB (L3).
+static const int GEMM_MC = 96;
+static const int GEMM_KC = 256;
+static const int GEMM_NC = 2048;
+
+void dgemm_ukernel_generic(int kc, const double *ap, const double *bp, double *c, int ldc) {
+    const int MR = GEMM_MR_GENERIC, NR = GEMM_NR_GENERIC;
+
+    // plain loops over a register-sized tile, left to the auto-vectorizer
+    double acc[MR][NR] = {};
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < MR; i++) {
+            for (int j = 0; j < NR; j++) {
+                acc[i][j] += ap[i] * bp[j];
+            }
+        }
+        ap += MR;
+        bp += NR;
+    }
+
+    for (int i = 0; i < MR; i++) {
+        for (int j = 0; j < NR; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+static GemmMicroKernel gemm_micro_kernel(Isa isa) {
+    switch (isa) {
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return {GEMM_MR_AVX2, GEMM_NR_AVX2, dgemm_ukernel_avx2};
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return {GEMM_MR_AVX512, GEMM_NR_AVX512, dgemm_ukernel_avx512};
+#endif
+    default:
+        // SSE2 is the x86-64 baseline, the generic kernel already uses it
+        return {GEMM_MR_GENERIC, GEMM_NR_GENERIC, dgemm_ukernel_generic};
+    }
+}
+
+Isa dgemm_selected_isa() {
+    // resolved once, on first use (thread-safe static initialization)
+    static const Isa isa = isa_select("SC4PS_GEMM_ISA");
+    return isa;
+}
+
+static double *alloc_panel(size_t n) {
+    void *p = nullptr;
+    if (posix_memalign(&p, 64, n * sizeof(double)) != 0) {
+        throw std::bad_alloc();
+    }
+    return static_cast<double *>(p);
+}
+
+// Pack the mc x kc block of alpha*A in micro-panels of MR rows,
+// zero-padding the last one.
+static void pack_a(int mc, int kc, const double *a, int lda, double alpha, int mr, double *ap) {
+    for (int ir = 0; ir < mc; ir += mr) {
+        const int rows = std::min(mr, mc - ir);
+        for (int i = 0; i < rows; i++) {
+            const double *ai = a + (size_t)(ir + i) * lda;
+            for (int p = 0; p < kc; p++) {
+                ap[p * mr + i] = alpha * ai[p];
+            }
+        }
+        for (int i = rows; i < mr; i++) {
+            for (int p = 0; p < kc; p++) {
+                ap[p * mr + i] = 0.0;
+            }
+        }
+        ap += (size_t)mr * kc;
+    }
+}
+
+// Pack the kc x nc slab of B in micro-panels of NR columns,
+// zero-padding the last one.
+static void pack_b(int kc, int nc, const double *b, int ldb, int nr, double *bp) {
+    for (int jr = 0; jr < nc; jr += nr) {
+        const int cols = std::min(nr, nc - jr);
+        for (int p = 0; p < kc; p++) {
+            const double *bpj = b + (size_t)p * ldb + jr;
+            double *dst = bp + p * nr;
+            std::memcpy(dst, bpj, cols * sizeof(double));
+            for (int j = cols; j < nr; j++) {
+                dst[j] = 0.0;
+            }
+        }
+        bp += (size_t)nr * kc;
+    }
+}
+
+// C[mc x nc] += Ap * Bp over packed blocks, one micro-tile at a time.
+// Ragged tiles at the edges go through a scratch tile.
+static void macro_kernel(const GemmMicroKernel &uk, int mc, int nc, int kc,
+                         const double *ap, const double *bp, double *c, int ldc) {
+    alignas(64) double tile[GEMM_MAX_TILE];
+
+    for (int jr = 0; jr < nc; jr += uk.nr) {
+        const int cols = std::min(uk.nr, nc - jr);
+        for (int ir = 0; ir < mc; ir += uk.mr) {
+            const int rows = std::min(uk.mr, mc - ir);
+            double *cij = c + (size_t)ir * ldc + jr;
+            const double *api = ap + (size_t)ir * kc;
+            const double *bpj = bp + (size_t)jr * kc;
+
+            if (rows == uk.mr && cols == uk.nr) {
+                uk.run(kc, api, bpj, cij, ldc);
+            } else {
+                std::fill(tile, tile + uk.mr * uk.nr, 0.0);
+                uk.run(kc, api, bpj, tile, uk.nr);
+                for (int i = 0; i < rows; i++) {
+                    for (int j = 0; j < cols; j++) {
+                        cij[(size_t)i * ldc + j] += tile[i * uk.nr + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void scale_c(int m, int n, double beta, double *c, int ldc) {
+    if (beta == 1.0) {
+        return;
+    }
+    for (int i = 0; i < m; i++) {
+        double *ci = c + (size_t)i * ldc;
+        if (beta == 0.0) {
+            // do not propagate NaN/Inf from uninitialized C
+            std::fill(ci, ci + n, 0.0);
+        } else {
+            for (int j = 0; j < n; j++) {
+                ci[j] *= beta;
+            }
+        }
+    }
+}
+
+// Serial loop nest on one (sub-)problem, with caller-owned packing
+// buffers of at least MC x KC and KC x NC doubles (rounded up to whole
+// micro-panels). C must already be scaled by beta.
+static void gemm_loop_nest(const GemmMicroKernel &uk, int m, int n, int k, double alpha,
+                           const double *a, int lda, const double *b, int ldb,
+                           double *c, int ldc, double *ap, double *bp) {
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        const int nc = std::min(GEMM_NC, n - jc);
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            const int kc = std::min(GEMM_KC, k - pc);
+            pack_b(kc, nc, b + (size_t)pc * ldb + jc, ldb, uk.nr, bp);
+
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                const int mc = std::min(GEMM_MC, m - ic);
+                pack_a(mc, kc, a + (size_t)ic * lda + pc, lda, alpha, uk.mr, ap);
+                macro_kernel(uk, mc, nc, kc, ap, bp, c + (size_t)ic * ldc + jc, ldc);
+            }
+        }
+    }
+}
+
+static const GemmMicroKernel &selected_micro_kernel() {
+    static const GemmMicroKernel uk = gemm_micro_kernel(dgemm_selected_isa());
+    return uk;
+}
+
+// Packing buffers of one thread, grown on demand and kept for the next
+// calls, so repeated products (e.g. the leaves of a Strassen recursion)
+// do not hit the allocator. Under OpenMP every worker gets its own.
+struct PackingBuffers {
+    double *ap = nullptr, *bp = nullptr;
+    size_t ap_size = 0, bp_size = 0;
+
+    ~PackingBuffers() {
+        free(ap);
+        free(bp);
+    }
+
+    void reserve(size_t a_size, size_t b_size) {
+        if (a_size > ap_size) {
+            free(ap);
+            ap = alloc_panel(a_size);
+            ap_size = a_size;
+        }
+        if (b_size > bp_size) {
+            free(bp);
+            bp = alloc_panel(b_size);
+            bp_size = b_size;
+        }
+    }
+};
+
+static thread_local PackingBuffers packing_buffers;
+
+// Blocked dgemm on one thread, with the packing buffers of this thread
+// sized for the problem at hand.
+static void gemm_single_thread(const GemmMicroKernel &uk, int m, int n, int k, double alpha,
+                               const double *a, int lda, const double *b, int ldb,
+                               double beta, double *c, int ldc) {
+    scale_c(m, n, beta, c, ldc);
+    if (k <= 0 || alpha == 0.0) {
+        return;
+    }
+
+    // packing buffers, rounded up to whole micro-panels
+    const int mc_max = std::min(GEMM_MC, (m + uk.mr - 1) / uk.mr * uk.mr);
+    const int nc_max = std::min(GEMM_NC, (n + uk.nr - 1) / uk.nr * uk.nr);
+    const int kc_max = std::min(GEMM_KC, k);
+    PackingBuffers &buffers = packing_buffers;
+    buffers.reserve((size_t)mc_max * kc_max, (size_t)nc_max * kc_max);
+
+    gemm_loop_nest(uk, m, n, k, alpha, a, lda, b, ldb, c, ldc, buffers.ap, buffers.bp);
+}
+
+void dgemm(int m, int n, int k, double alpha, const double *a, int lda,
+           const double *b, int ldb, double beta, double *c, int ldc) {
+
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+    gemm_single_thread(selected_micro_kernel(), m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+// Split p threads in a pm x pn grid whose tiles are as square as
+// possible, i.e. minimize the A rows + B columns each thread streams.
+static void thread_grid(int m, int n, int p, int &pm, int &pn) {
+    pm = 1;
+    pn = p;
+    double best = -1.0;
+    for (int rows = 1; rows <= p; rows++) {
+        if (p % rows != 0) {
+            continue;
+        }
+        const double cost = (double)m / rows + (double)n / (p / rows);
+        if (best < 0.0 || cost < best) {
+            best = cost;
+            pm = rows;
+            pn = p / rows;
+        }
+    }
+}
+
+// [begin, end) of part i out of parts, in whole units of unit
+static void split_range(int len, int parts, int i, int unit, int &begin, int &end) {
+    const int units = (len + unit - 1) / unit;
+    begin = std::min(len, (int)((long)units * i / parts) * unit);
+    end = std::min(len, (int)((long)units * (i + 1) / parts) * unit);
+}
+
+void dgemm_parallel(int m, int n, int k, double alpha, const double *a, int lda,
+                    const double *b, int ldb, double beta, double *c, int ldc) {
+
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+
+    const GemmMicroKernel &uk = selected_micro_kernel();
+
+#if defined(_OPENMP)
+    #pragma omp parallel
+    {
+        // every thread owns one 2D tile of C, cut on micro-tile
+        // boundaries, and packs A and B in its own buffers
+        const int p = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        int pm, pn;
+        thread_grid(m, n, p, pm, pn);
+
+        int i0, i1, j0, j1;
+        split_range(m, pm, t / pn, uk.mr, i0, i1);
+        split_range(n, pn, t % pn, uk.nr, j0, j1);
+
+        if (i1 > i0 && j1 > j0) {
+            gemm_single_thread(uk, i1 - i0, j1 - j0, k, alpha, a + (size_t)i0 * lda, lda,
+                               b + j0, ldb, beta, c + (size_t)i0 * ldc + j0, ldc);
+        }
+    }
+#else
+    gemm_single_thread(uk, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+#endif
+}
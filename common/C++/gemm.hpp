@@ -0,0 +1,45 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+
+#include <cstddef>
+
+#include "isa.hpp"
+
+// Blocked general matrix multiply, C = alpha*A*B + beta*C.
+// A is m x k, B is k x n and C is m x n, all row-major with row strides
+// lda, ldb and ldc (so sub-matrices can be passed in place).
+//
+// Goto/BLIS-style loop nest: B is packed in KC x NC slabs that stay in
+// L3, A in MC x KC blocks that stay in L2, both laid out as contiguous
+// micro-panels, and a register-tiled MR x NR micro-kernel streams them
+// from L1. The micro-kernel (AVX-512, AVX2+FMA or generic) is picked at
+// runtime; it can be forced with SC4PS_GEMM_ISA=scalar|sse2|avx2|avx512.
+void dgemm(int m, int n, int k, double alpha, const double *a, int lda,
+           const double *b, int ldb, double beta, double *c, int ldc);
+
+// Same as dgemm, multithreaded with OpenMP (OMP_NUM_THREADS threads).
+// C is split in a 2D grid of tiles, one per thread, cut on micro-tile
+// boundaries; each thread packs its own A and B panels into private
+// buffers, so threads share nothing but the read-only inputs.
+// (Packing buffers are cached per thread and reused by later calls.)
+// Falls back to dgemm if the library is built without OpenMP.
+void dgemm_parallel(int m, int n, int k, double alpha, const double *a, int lda,
+                    const double *b, int ldb, double beta, double *c, int ldc);
+
+// C = A*B for n x n matrices with the Strassen-Winograd algorithm:
+// 7 half-size products per level, recursing down to n <= cutoff, where
+// dgemm_parallel takes over. Odd sizes are peeled one row/column at a time.
+// All the temporaries live in one workspace of
+// dgemm_strassen_workspace(n, cutoff) doubles, allocated up front (or
+// passed in), so nothing is allocated inside the recursion.
+// Trades some accuracy for speed: the error bound grows faster with n
+// than the one of the classic algorithm.
+const int STRASSEN_DEFAULT_CUTOFF = 512;
+
+size_t dgemm_strassen_workspace(int n, int cutoff = STRASSEN_DEFAULT_CUTOFF);
+void dgemm_strassen(int n, const double *a, int lda, const double *b, int ldb, double *c, int ldc,
+                    int cutoff = STRASSEN_DEFAULT_CUTOFF, double *workspace = nullptr);
+
+Isa dgemm_selected_isa();
+
+#endif // GEMM_HPP
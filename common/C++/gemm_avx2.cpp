@@ -0,0 +1,33 @@
+#include <immintrin.h>
+
+#include "gemm_kernels.hpp"
+
+// 6 x 8 tile: 12 ymm accumulators, 2 loads of B and 6 broadcasts of A
+// per rank-1 update
+void dgemm_ukernel_avx2(int kc, const double *ap, const double *bp, double *c, int ldc) {
+    const int MR = GEMM_MR_AVX2;
+
+    __m256d acc[MR][2];
+    for (int i = 0; i < MR; i++) {
+        acc[i][0] = _mm256_setzero_pd();
+        acc[i][1] = _mm256_setzero_pd();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m256d b0 = _mm256_load_pd(bp);
+        const __m256d b1 = _mm256_load_pd(bp + 4);
+        for (int i = 0; i < MR; i++) {
+            const __m256d ai = _mm256_broadcast_sd(ap + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        ap += MR;
+        bp += GEMM_NR_AVX2;
+    }
+
+    for (int i = 0; i < MR; i++) {
+        double *ci = c + i * ldc;
+        _mm256_storeu_pd(ci, _mm256_add_pd(_mm256_loadu_pd(ci), acc[i][0]));
+        _mm256_storeu_pd(ci + 4, _mm256_add_pd(_mm256_loadu_pd(ci + 4), acc[i][1]));
+    }
+}
@@ -0,0 +1,33 @@
+#include <immintrin.h>
+
+#include "gemm_kernels.hpp"
+
+// 8 x 16 tile: 16 zmm accumulators, 2 loads of B and 8 broadcasts of A
+// per rank-1 update
+void dgemm_ukernel_avx512(int kc, const double *ap, const double *bp, double *c, int ldc) {
+    const int MR = GEMM_MR_AVX512;
+
+    __m512d acc[MR][2];
+    for (int i = 0; i < MR; i++) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m512d b0 = _mm512_load_pd(bp);
+        const __m512d b1 = _mm512_load_pd(bp + 8);
+        for (int i = 0; i < MR; i++) {
+            const __m512d ai = _mm512_set1_pd(ap[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        ap += MR;
+        bp += GEMM_NR_AVX512;
+    }
+
+    for (int i = 0; i < MR; i++) {
+        double *ci = c + i * ldc;
+        _mm512_storeu_pd(ci, _mm512_add_pd(_mm512_loadu_pd(ci), acc[i][0]));
+        _mm512_storeu_pd(ci + 8, _mm512_add_pd(_mm512_loadu_pd(ci + 8), acc[i][1]));
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef GEMM_KERNELS_HPP
+#define GEMM_KERNELS_HPP
+
+// Internal: register-tiled micro-kernels, C[MR x NR] += Ap * Bp.
+// Ap holds kc columns of MR rows (Ap[p*MR + i]), Bp holds kc rows of
+// NR columns (Bp[p*NR + j]), both 64-byte aligned; C is row-major with
+// row stride ldc. Each ISA-specific one lives in its own translation unit.
+
+typedef void (*gemm_ukernel_t)(int kc, const double *ap, const double *bp, double *c, int ldc);
+
+struct GemmMicroKernel {
+    int mr;
+    int nr;
+    gemm_ukernel_t run;
+};
+
+const int GEMM_MR_GENERIC = 4, GEMM_NR_GENERIC = 8;
+const int GEMM_MR_AVX2 = 6, GEMM_NR_AVX2 = 8;
+const int GEMM_MR_AVX512 = 8, GEMM_NR_AVX512 = 16;
+
+// largest MR * NR above, size of the scratch tile for the edges
+const int GEMM_MAX_TILE = 8 * 16;
+
+void dgemm_ukernel_generic(int kc, const double *ap, const double *bp, double *c, int ldc);
+void dgemm_ukernel_avx2(int kc, const double *ap, const double *bp, double *c, int ldc);
+void dgemm_ukernel_avx512(int kc, const double *ap, const double *bp, double *c, int ldc);
+
+#endif // GEMM_KERNELS_HPP
@@ -0,0 +1,64 @@
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "isa.hpp"
+
+bool isa_supported(Isa isa) {
+#if defined(SC4PS_HAVE_SSE2)
+    // needed if we get called before the static constructors have run
+    __builtin_cpu_init();
+#endif
+
+    switch (isa) {
+    case Isa::Scalar:
+        return true;
+#if defined(SC4PS_HAVE_SSE2)
+    case Isa::SSE2:
+        return __builtin_cpu_supports("sse2");
+#endif
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *isa_name(Isa isa) {
+    switch (isa) {
+    case Isa::SSE2:
+        return "sse2";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+Isa isa_select(const char *env_var) {
+    // honour an explicit request first, if the host can run it
+    const char *forced = env_var != nullptr ? std::getenv(env_var) : nullptr;
+    if (forced != nullptr) {
+        for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+            if (strcmp(forced, isa_name(isa)) == 0 && isa_supported(isa)) {
+                return isa;
+            }
+        }
+    }
+
+    // otherwise take the widest one available
+    for (Isa isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2}) {
+        if (isa_supported(isa)) {
+            return isa;
+        }
+    }
+    return Isa::Scalar;
+}
@@ -0,0 +1,16 @@
+#ifndef ISA_HPP
+#define ISA_HPP
+
+// Instruction sets the kernels of this library are built for.
+// AVX2 stands for AVX2 + FMA (x86-64-v3), AVX512 for AVX-512F.
+enum class Isa { Scalar = 0, SSE2, AVX2, AVX512 };
+
+// true if both this build and the host CPU (checked via CPUID) can run it
+bool isa_supported(Isa isa);
+const char *isa_name(Isa isa);
+
+// Widest supported instruction set. If the environment variable env_var
+// names a supported one (scalar|sse2|avx2|avx512), that is returned instead.
+Isa isa_select(const char *env_var);
+
+#endif // ISA_HPP
@@ -0,0 +1,123 @@
+#ifndef MATRIX_HPP
+#define MATRIX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Dense row-major matrices in one contiguous, 64-byte aligned block.
+// Rows are padded to a whole number of cache lines, so every row starts
+// aligned; stride() is the distance between rows, in elements.
+
+// Non-owning, strided view of a matrix or of a sub-block of it.
+// T is double for a mutable view, const double for a read-only one.
+template <typename T>
+class BasicMatrixView {
+public:
+    BasicMatrixView(T *data, size_t rows, size_t cols, size_t stride)
+        : data_(data), rows_(rows), cols_(cols), stride_(stride) {}
+
+    // a mutable view converts to a read-only one
+    template <typename U>
+    BasicMatrixView(const BasicMatrixView<U> &other)
+        : data_(other.data()), rows_(other.rows()), cols_(other.cols()), stride_(other.stride()) {}
+
+    T &operator()(size_t i, size_t j) const { return data_[i * stride_ + j]; }
+    T *row(size_t i) const { return data_ + i * stride_; }
+    T *data() const { return data_; }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+
+    // r x c sub-block starting at (i0, j0), sharing the same storage
+    BasicMatrixView block(size_t i0, size_t j0, size_t r, size_t c) const {
+        return BasicMatrixView(data_ + i0 * stride_ + j0, r, c, stride_);
+    }
+
+private:
+    T *data_;
+    size_t rows_, cols_, stride_;
+};
+
+typedef BasicMatrixView<double> MatrixView;
+typedef BasicMatrixView<const double> ConstMatrixView;
+
+// Owning matrix. Move-only: copying N^2 doubles has to be explicit
+// (see copy()), so it can not happen by accident through a by-value
+// argument.
+class Matrix {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    Matrix() : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+
+    Matrix(size_t rows, size_t cols, double init_value = 0.0)
+        : rows_(rows), cols_(cols), stride_(padded(cols)) {
+        void *p = nullptr;
+        if (posix_memalign(&p, ALIGNMENT, std::max<size_t>(1, rows_ * stride_) * sizeof(double)) != 0) {
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<double *>(p);
+        std::fill(data_, data_ + rows_ * stride_, init_value);
+    }
+
+    Matrix(const Matrix &) = delete;
+    Matrix &operator=(const Matrix &) = delete;
+
+    Matrix(Matrix &&other) noexcept
+        : data_(other.data_), rows_(other.rows_), cols_(other.cols_), stride_(other.stride_) {
+        other.data_ = nullptr;
+        other.rows_ = other.cols_ = other.stride_ = 0;
+    }
+
+    Matrix &operator=(Matrix &&other) noexcept {
+        if (this != &other) {
+            free(data_);
+            data_ = other.data_;
+            rows_ = other.rows_;
+            cols_ = other.cols_;
+            stride_ = other.stride_;
+            other.data_ = nullptr;
+            other.rows_ = other.cols_ = other.stride_ = 0;
+        }
+        return *this;
+    }
+
+    ~Matrix() { free(data_); }
+
+    Matrix copy() const {
+        Matrix m(rows_, cols_);
+        std::copy(data_, data_ + rows_ * stride_, m.data_);
+        return m;
+    }
+
+    double &operator()(size_t i, size_t j) { return data_[i * stride_ + j]; }
+    const double &operator()(size_t i, size_t j) const { return data_[i * stride_ + j]; }
+    double *row(size_t i) { return data_ + i * stride_; }
+    const double *row(size_t i) const { return data_ + i * stride_; }
+    double *data() { return data_; }
+    const double *data() const { return data_; }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+
+    MatrixView view() { return MatrixView(data_, rows_, cols_, stride_); }
+    ConstMatrixView view() const { return ConstMatrixView(data_, rows_, cols_, stride_); }
+    MatrixView block(size_t i0, size_t j0, size_t r, size_t c) { return view().block(i0, j0, r, c); }
+    ConstMatrixView block(size_t i0, size_t j0, size_t r, size_t c) const { return view().block(i0, j0, r, c); }
+
+private:
+    // round cols up to a whole number of cache lines
+    static size_t padded(size_t cols) {
+        const size_t per_line = ALIGNMENT / sizeof(double);
+        return (cols + per_line - 1) / per_line * per_line;
+    }
+
+    double *data_;
+    size_t rows_, cols_, stride_;
+};
+
+#endif // MATRIX_HPP
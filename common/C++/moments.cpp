@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+
+#include "moments.hpp"
+
+// 2048 doubles, 16 KiB: the second sweep of a block hits L1
+static const int MOMENTS_BLOCK = 2048;
+
+void moments_clear(Moments &m) {
+    m.n = 0.0;
+    m.mean = 0.0;
+    m.m2 = 0.0;
+    m.m3 = 0.0;
+    m.m4 = 0.0;
+}
+
+void moments_merge(Moments &a, const Moments &b) {
+    if (b.n == 0.0) {
+        return;
+    }
+    if (a.n == 0.0) {
+        a = b;
+        return;
+    }
+
+    double n = a.n + b.n;
+    double delta = b.mean - a.mean;
+    double delta_n = delta / n;
+    double ab = a.n * b.n;
+
+    double m4 = a.m4 + b.m4 + delta * delta_n * delta_n * delta_n * ab * (a.n * a.n - ab + b.n * b.n)
+              + 6.0 * delta_n * delta_n * (a.n * a.n * b.m2 + b.n * b.n * a.m2)
+              + 4.0 * delta_n * (a.n * b.m3 - b.n * a.m3);
+    double m3 = a.m3 + b.m3 + delta * delta_n * delta_n * ab * (a.n - b.n)
+              + 3.0 * delta_n * (a.n * b.m2 - b.n * a.m2);
+    double m2 = a.m2 + b.m2 + delta * delta_n * ab;
+
+    a.mean += delta_n * b.n;
+    a.m2 = m2;
+    a.m3 = m3;
+    a.m4 = m4;
+    a.n = n;
+}
+
+static Moments block_moments(const double *vec, int n) {
+    /*
+    Corrected two-pass algorithm on one block: the mean first, then the
+    powers of the deviations. The sum of the deviations, zero in exact
+    arithmetic, corrects the rounding error of the mean.
+    */
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += vec[i];
+    }
+    double mean = sum / n;
+
+    double s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = vec[i] - mean;
+        double d2 = d * d;
+        s1 += d;
+        s2 += d2;
+        s3 += d2 * d;
+        s4 += d2 * d2;
+    }
+
+    Moments m;
+    m.n = n;
+    m.mean = mean + s1 / n;
+    m.m2 = s2 - s1 * s1 / n;
+    m.m3 = s3;
+    m.m4 = s4;
+    return m;
+}
+
+void moments_add(Moments &m, const double *vec, int n) {
+    for (int start = 0; start < n; start += MOMENTS_BLOCK) {
+        moments_merge(m, block_moments(vec + start, std::min(MOMENTS_BLOCK, n - start)));
+    }
+}
+
+double moments_variance(const Moments &m) {
+    return m.n > 1.0 ? m.m2 / (m.n - 1.0) : 0.0;
+}
+
+double moments_stdev(const Moments &m) {
+    return std::sqrt(moments_variance(m));
+}
+
+double moments_skewness(const Moments &m) {
+    return m.m2 > 0.0 ? std::sqrt(m.n) * m.m3 / (m.m2 * std::sqrt(m.m2)) : 0.0;
+}
+
+double moments_excess_kurtosis(const Moments &m) {
+    return m.m2 > 0.0 ? m.n * m.m4 / (m.m2 * m.m2) - 3.0 : 0.0;
+}
+
+Moments StreamingMoments(const double *vec, int n) {
+    Moments m;
+    moments_clear(m);
+    moments_add(m, vec, n);
+    return m;
+}
+
+Moments StreamingMoments_parallel(const double *vec, int n) {
+    const int blocks = (n + MOMENTS_BLOCK - 1) / MOMENTS_BLOCK;
+
+    Moments m;
+    moments_clear(m);
+
+    #pragma omp parallel for schedule(static) reduction(moments_merge: m)
+    for (int b = 0; b < blocks; b++) {
+        int start = b * MOMENTS_BLOCK;
+        moments_add(m, vec + start, std::min(MOMENTS_BLOCK, n - start));
+    }
+    return m;
+}
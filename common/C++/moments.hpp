@@ -0,0 +1,40 @@
+#ifndef MOMENTS_HPP
+#define MOMENTS_HPP
+
+// Streaming mean, variance, skewness and kurtosis in one pass.
+// The data is taken in cache-sized blocks: a block's central moments are
+// computed around its own mean (corrected two-pass, in L1 cache) and
+// merged into the running ones with the pairwise formulas of Chan,
+// Golub & LeVeque, extended to M3 and M4 by Pébay. Merging partial
+// moments is thus as stable as adding more data, so they can be built
+// per thread, per rank or per I/O block and combined afterwards.
+struct Moments {
+    double n;       // count, as a double for the merge formulas
+    double mean;
+    double m2;      // sums of the 2nd, 3rd and 4th powers of the
+    double m3;      // deviations from the mean
+    double m4;
+};
+
+void moments_clear(Moments &m);
+void moments_add(Moments &m, const double *vec, int n);
+// a += b
+void moments_merge(Moments &a, const Moments &b);
+
+// Sample variance (n - 1 in the denominator) and its square root
+double moments_variance(const Moments &m);
+double moments_stdev(const Moments &m);
+// g1 = m3 / n / (m2 / n)^1.5 and g2 = n m4 / m2^2 - 3 (0 for a normal)
+double moments_skewness(const Moments &m);
+double moments_excess_kurtosis(const Moments &m);
+
+#ifdef _OPENMP
+#pragma omp declare reduction(moments_merge : Moments : moments_merge(omp_out, omp_in)) \
+    initializer(moments_clear(omp_priv))
+#endif
+
+Moments StreamingMoments(const double *vec, int n);
+// Multithreaded with OpenMP
+Moments StreamingMoments_parallel(const double *vec, int n);
+
+#endif // MOMENTS_HPP
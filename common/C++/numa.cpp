@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "numa.hpp"
+
+static const size_t NUMA_PAGE = 4096;
+
+struct Topology {
+    std::vector<int> node_of_cpu;        // -1 for CPUs not in any node
+    std::vector<std::vector<int>> cpus;  // per node, allowed ones only
+    std::vector<int> allowed;            // all allowed CPUs
+};
+
+static std::vector<int> parse_cpu_list(const std::string &list) {
+    // "0-3,8-11"
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string range = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last && !range.empty(); cpu++) {
+            cpus.push_back(cpu);
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+static std::vector<int> allowed_cpus() {
+    // the CPUs of the process mask when first asked, i.e. before any
+    // pin_threads narrowed the mask of the master thread
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int cpu = 0; cpu < std::max(online, 1L); cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+#else
+    cpus.push_back(0);
+#endif
+    return cpus;
+}
+
+static const Topology &topology() {
+    static const Topology t = [] {
+        Topology t;
+        t.allowed = allowed_cpus();
+
+        std::ifstream online_file("/sys/devices/system/node/online");
+        std::string online;
+        std::vector<int> nodes;
+        if (online_file >> online) {
+            nodes = parse_cpu_list(online);
+        }
+        int max_node = nodes.empty() ? 0 : *std::max_element(nodes.begin(), nodes.end());
+        t.cpus.resize(max_node + 1);
+
+        for (int node: nodes) {
+            std::ifstream list_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!(list_file >> list)) {
+                continue;
+            }
+            for (int cpu: parse_cpu_list(list)) {
+                if (cpu >= (int)t.node_of_cpu.size()) {
+                    t.node_of_cpu.resize(cpu + 1, -1);
+                }
+                t.node_of_cpu[cpu] = node;
+            }
+        }
+
+        for (int cpu: t.allowed) {
+            // CPUs sysfs does not know of go to node 0
+            int node = cpu < (int)t.node_of_cpu.size() && t.node_of_cpu[cpu] >= 0 ? t.node_of_cpu[cpu] : 0;
+            t.cpus[node].push_back(cpu);
+        }
+        return t;
+    }();
+    return t;
+}
+
+int numa_node_count() {
+    return (int)topology().cpus.size();
+}
+
+int numa_node_of_cpu(int cpu) {
+    const Topology &t = topology();
+    if (cpu < 0 || cpu >= (int)t.node_of_cpu.size() || t.node_of_cpu[cpu] < 0) {
+        return 0;
+    }
+    return t.node_of_cpu[cpu];
+}
+
+std::vector<int> numa_node_cpus(int node) {
+    const Topology &t = topology();
+    if (node < 0 || node >= (int)t.cpus.size()) {
+        return {};
+    }
+    return t.cpus[node];
+}
+
+int numa_current_node() {
+#if defined(__linux__)
+    return numa_node_of_cpu(sched_getcpu());
+#else
+    return 0;
+#endif
+}
+
+void numa_static_slice(size_t n, int thread, int threads, size_t &begin, size_t &end) {
+    size_t q = n / threads, r = n % threads;
+    size_t t = thread;
+    begin = t * q + std::min(t, r);
+    end = begin + q + (t < r ? 1 : 0);
+}
+
+void parallel_fill(size_t n, double value, double *x) {
+    #pragma omp parallel
+    {
+        int thread = 0, threads = 1;
+#if defined(_OPENMP)
+        thread = omp_get_thread_num();
+        threads = omp_get_num_threads();
+#endif
+        size_t begin, end;
+        numa_static_slice(n, thread, threads, begin, end);
+        std::fill(x + begin, x + end, value);
+    }
+}
+
+double *numa_alloc_first_touch(size_t n, double value) {
+    /*
+    Whole pages, so that no page is shared with another allocation that
+    some other thread may have touched first: the first write to every
+    page of x is the one of parallel_fill.
+    */
+    size_t bytes = (std::max(n, (size_t)1) * sizeof(double) + NUMA_PAGE - 1) / NUMA_PAGE * NUMA_PAGE;
+    double *x = static_cast<double *>(std::aligned_alloc(NUMA_PAGE, bytes));
+    if (x != nullptr) {
+        parallel_fill(n, value, x);
+    }
+    return x;
+}
+
+void numa_free(double *x) {
+    std::free(x);
+}
+
+std::vector<size_t> numa_pages_per_node(const double *x, size_t n, size_t max_pages) {
+    std::vector<size_t> pages(numa_node_count(), 0);
+#if defined(__linux__) && defined(SYS_move_pages)
+    uintptr_t first = (uintptr_t)x / NUMA_PAGE * NUMA_PAGE;
+    uintptr_t last = (uintptr_t)(x + n);
+    size_t count = n == 0 ? 0 : (last - first + NUMA_PAGE - 1) / NUMA_PAGE;
+    size_t stride = std::max<size_t>(1, (count + max_pages - 1) / std::max<size_t>(max_pages, 1));
+
+    std::vector<void *> addresses;
+    for (size_t p = 0; p < count; p += stride) {
+        addresses.push_back((void *)(first + p * NUMA_PAGE));
+    }
+    // with no target nodes, move_pages only reports where the pages are
+    std::vector<int> status(addresses.size(), -1);
+    if (syscall(SYS_move_pages, 0, addresses.size(), addresses.data(), nullptr, status.data(), 0) != 0) {
+        return {};
+    }
+    for (int node: status) {
+        // negative: -errno, e.g. a page never touched
+        if (node >= 0 && node < (int)pages.size()) {
+            pages[node]++;
+        }
+    }
+    return pages;
+#else
+    (void)x;
+    (void)n;
+    (void)max_pages;
+    return {};
+#endif
+}
+
+const char *affinity_name(Affinity affinity) {
+    switch (affinity) {
+    case Affinity::Compact:
+        return "compact";
+    case Affinity::Scatter:
+        return "scatter";
+    default:
+        return "none";
+    }
+}
+
+bool affinity_from_name(const char *name, Affinity &affinity) {
+    for (Affinity a: {Affinity::None, Affinity::Compact, Affinity::Scatter}) {
+        if (std::strcmp(name, affinity_name(a)) == 0) {
+            affinity = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::vector<int> cpu_order(Affinity affinity) {
+    const Topology &t = topology();
+    std::vector<int> order;
+    if (affinity == Affinity::Compact) {
+        for (const std::vector<int> &cpus: t.cpus) {
+            order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+    } else {
+        // one CPU of each node in turn, skipping the nodes run out of
+        for (size_t i = 0; order.size() < t.allowed.size(); i++) {
+            for (const std::vector<int> &cpus: t.cpus) {
+                if (i < cpus.size()) {
+                    order.push_back(cpus[i]);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+int pin_threads(Affinity affinity) {
+#if defined(__linux__)
+    const Topology &t = topology();
+    const std::vector<int> order = cpu_order(affinity);
+    if (t.allowed.empty()) {
+        return 0;
+    }
+
+    int pinned = 0;
+    #pragma omp parallel reduction(+: pinned)
+    {
+        int thread = 0;
+#if defined(_OPENMP)
+        thread = omp_get_thread_num();
+#endif
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (affinity == Affinity::None) {
+            for (int cpu: t.allowed) {
+                CPU_SET(cpu, &set);
+            }
+        } else {
+            CPU_SET(order[thread % order.size()], &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) == 0 && affinity != Affinity::None) {
+            pinned++;
+        }
+    }
+    return pinned;
+#else
+    (void)affinity;
+    return 0;
+#endif
+}
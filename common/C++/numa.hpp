@@ -0,0 +1,77 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <cstddef>
+#include <vector>
+
+// NUMA placement for the OpenMP kernels, without libnuma.
+// Linux puts a page on the node of the thread that first writes it, so
+// vectors allocated by one thread and initialized by a serial loop all
+// land on that thread's node, and every other socket reads them through
+// the interconnect. numa_alloc_first_touch initializes them with the
+// split of numa_static_slice, and loops that take their elements from
+// numa_static_slice too find each thread's slice on its own node. That
+// only holds while threads stay on their CPUs: pin them first
+// (pin_threads, or OMP_PROC_BIND / OMP_PLACES).
+// Loops that follow the split: parallel_fill, and in the 09 OpenMP
+// driver daxpy_parallel, daxpy_parallel_per_node and the chunked
+// kernels (daxpy_chunked_parallel, sum_chunked_parallel,
+// daxpy_sum_chunked_parallel), which cut each thread's slice into
+// chunks. The fused one sums a chunk that straddles two slices after a
+// barrier, reading at most one chunk of the neighbouring slice. The
+// parallel chunk-size probes of tuning.cpp walk the same slices, on
+// scratch vectors that are not first-touched.
+// Loops that do not: the fixed-block loops of the library
+// (KahanBabushkaNeumaierSum_parallel, ReproducibleSum_parallel,
+// ExactSum_parallel, StreamingMoments_parallel, hence sum_with_parallel),
+// whose blocks must not depend on the thread count; their schedule(static)
+// share of whole blocks is each thread's slice give or take one block
+// at each end. The gemm, Strassen and rng loops do not either.
+// The topology is read from /sys/devices/system/node; without it there
+// is one node with all the CPUs.
+
+int numa_node_count();
+// Node of a CPU, 0 if unknown
+int numa_node_of_cpu(int cpu);
+// CPUs of a node this process may run on, in increasing order
+std::vector<int> numa_node_cpus(int node);
+// Node of the CPU the calling thread is running on
+int numa_current_node();
+
+// Elements [begin, end) of thread out of threads: contiguous slices, the
+// first n % threads one element longer. libgomp splits schedule(static)
+// loops the same way, other runtimes need not (LLVM's libomp gives
+// ceil(n / threads) to each thread), so use it rather than rely on that
+void numa_static_slice(size_t n, int thread, int threads, size_t &begin, size_t &end);
+
+// x[i] = value, each thread writing its numa_static_slice
+void parallel_fill(size_t n, double value, double *x);
+
+// Page-aligned vector of n doubles, set to value by parallel_fill.
+// nullptr if the allocation fails; release with numa_free.
+double *numa_alloc_first_touch(size_t n, double value);
+void numa_free(double *x);
+
+// Number of pages of x[0, n) on each node, from a sample of at most
+// max_pages pages; empty if the kernel cannot tell (no move_pages)
+std::vector<size_t> numa_pages_per_node(const double *x, size_t n, size_t max_pages = 4096);
+
+// Thread placement for the OpenMP teams:
+// Compact fills the CPUs of node 0, then node 1, ... (threads sharing a
+// node share its caches and memory controllers), Scatter deals the
+// threads out over the nodes in turn (the bandwidth of every node from
+// the first threads on)
+enum class Affinity { None = 0, Compact, Scatter };
+
+const char *affinity_name(Affinity affinity);
+// "none", "compact" or "scatter"; false for anything else
+bool affinity_from_name(const char *name, Affinity &affinity);
+
+// Pins each thread of an OpenMP team of the current size to one CPU
+// (wrapping around when there are more threads than CPUs). The runtime
+// keeps its threads across parallel regions of the same size, so the
+// placement holds for the regions that follow. None unpins them.
+// Returns the number of threads pinned, 0 if not supported.
+int pin_threads(Affinity affinity);
+
+#endif // NUMA_HPP
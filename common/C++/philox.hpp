@@ -0,0 +1,45 @@
+#ifndef PHILOX_HPP
+#define PHILOX_HPP
+
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", SC'11). It is a keyed bijection of a
+// 128-bit counter: the key is the seed, and any counter value can be
+// evaluated on its own, so the n-th random number of a stream costs the
+// same as the first and disjoint index ranges can be generated by
+// different threads or ranks with identical results.
+
+struct Philox4x32 {
+    uint32_t v[4];
+};
+
+inline void philox_mulhilo(uint32_t a, uint32_t b, uint32_t &hi, uint32_t &lo) {
+    uint64_t product = uint64_t(a) * b;
+    hi = uint32_t(product >> 32);
+    lo = uint32_t(product);
+}
+
+inline Philox4x32 philox4x32(Philox4x32 ctr, uint32_t key0, uint32_t key1) {
+    const uint32_t M0 = 0xd2511f53, M1 = 0xcd9e8d57;
+    const uint32_t W0 = 0x9e3779b9, W1 = 0xbb67ae85;
+
+    for (int round = 0; round < 10; round++) {
+        uint32_t hi0, lo0, hi1, lo1;
+        philox_mulhilo(M0, ctr.v[0], hi0, lo0);
+        philox_mulhilo(M1, ctr.v[2], hi1, lo1);
+        ctr = {{hi1 ^ ctr.v[1] ^ key0, lo1, hi0 ^ ctr.v[3] ^ key1, lo0}};
+        key0 += W0;
+        key1 += W1;
+    }
+    return ctr;
+}
+
+// Uniform double in the open interval (0, 1) from 64 random bits, on a
+// grid of 2^-53 offset by half a step, so log() of it is always finite.
+inline double philox_uniform(uint32_t hi, uint32_t lo) {
+    uint64_t bits = (uint64_t(hi) << 32 | lo) >> 11;
+    return (bits + 0.5) * 0x1p-53;
+}
+
+#endif // PHILOX_HPP
@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "rng.hpp"
+#include "rng_kernels.hpp"
+
+normal_pairs_kernel_t rng_kernel(Isa isa) {
+    if (!isa_supported(isa)) {
+        return nullptr;
+    }
+
+    switch (isa) {
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return normal_pairs_avx2;
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return normal_pairs_avx512;
+#endif
+    default:
+        // scalar and SSE2 share the baseline build
+        return normal_pairs_generic;
+    }
+}
+
+Isa rng_selected_isa() {
+    static const Isa isa = isa_select("SC4PS_RNG_ISA");
+    return isa;
+}
+
+void philox_normal(uint64_t seed, uint64_t stream, uint64_t first, size_t n,
+                   double mean, double std, double *out) {
+    static const normal_pairs_kernel_t kernel = rng_kernel(rng_selected_isa());
+
+    if (n == 0) {
+        return;
+    }
+    uint64_t last = first + n; // one past
+    double pair[2];
+
+    // an odd first element takes the second half of its pair
+    if (first % 2 == 1) {
+        kernel(seed, stream, first / 2, 1, mean, std, pair);
+        *out++ = pair[1];
+        first++;
+    }
+    // and an odd end the first half of the last pair
+    if (first < last && last % 2 == 1) {
+        kernel(seed, stream, last / 2, 1, mean, std, pair);
+        out[last - 1 - first] = pair[0];
+        last--;
+    }
+
+    // whole pairs, one contiguous share per thread
+    size_t pairs = (last - first) / 2;
+    uint64_t first_block = first / 2;
+    #pragma omp parallel if(pairs >= 65536)
+    {
+        size_t begin = 0, end = pairs;
+#ifdef _OPENMP
+        size_t threads = omp_get_num_threads(), t = omp_get_thread_num();
+        begin = pairs * t / threads;
+        end = pairs * (t + 1) / threads;
+#endif
+        kernel(seed, stream, first_block + begin, end - begin, mean, std, out + 2 * begin);
+    }
+}
+
+void fill_normal(double *out, size_t n, double mean, double std, RngStream &stream) {
+    philox_normal(stream.seed, stream.stream, stream.position, n, mean, std, out);
+    stream.position += n;
+}
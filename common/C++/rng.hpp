@@ -0,0 +1,48 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "isa.hpp"
+
+// Normally distributed vectors from the Philox4x32-10 counter-based
+// generator (see philox.hpp). Element i of stream `stream` under `seed`
+// is a pure function of (seed, stream, i): counter (i / 2, stream) gives
+// two uniforms, Box-Muller turns them into elements 2*(i/2) and
+// 2*(i/2) + 1. Any index range can thus be generated independently, and
+// the output does not depend on how the range is split.
+//
+// Generation is vectorized (AVX-512, AVX2 or baseline SSE2, picked at
+// runtime) with in-house log and sin/cos made of basic IEEE operations
+// only, so the values are bit-identical on every ISA and thread count.
+// They agree with a libm-based Box-Muller to a few ulp.
+
+// out[j] = element first + j of the stream, for j < n, with the given
+// mean and standard deviation. Multithreaded with OpenMP for large n.
+void philox_normal(uint64_t seed, uint64_t stream, uint64_t first, size_t n,
+                   double mean, double std, double *out);
+
+// Position in a (seed, stream) sequence, for sequential consumers
+struct RngStream {
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t position; // index of the next element
+};
+
+// Bulk sampling: the next n elements of the stream, written straight
+// into out (which can be a mapped output file), and the stream advanced.
+void fill_normal(double *out, size_t n, double mean, double std, RngStream &stream);
+
+// Elements 2*(first_block + p) and 2*(first_block + p) + 1 of the
+// stream, for p < pairs: the vectorized kernel behind philox_normal
+typedef void (*normal_pairs_kernel_t)(uint64_t seed, uint64_t stream, uint64_t first_block, size_t pairs,
+                                      double mean, double std, double *out);
+
+// Introspection, mostly for benchmarks and tests.
+// The selection can be forced with the environment variable
+// SC4PS_RNG_ISA=scalar|sse2|avx2|avx512 (ignored if unsupported).
+Isa rng_selected_isa();
+normal_pairs_kernel_t rng_kernel(Isa isa); // nullptr if not supported
+
+#endif // RNG_HPP
@@ -0,0 +1,7 @@
+#include "rng_kernels.hpp"
+
+// Philox + Box-Muller, auto-vectorized for the AVX2, 4 pairs per vector
+void normal_pairs_avx2(uint64_t seed, uint64_t stream, uint64_t first_block, size_t pairs,
+                       double mean, double std, double *out) {
+    normal_pairs_body(seed, stream, first_block, pairs, mean, std, out);
+}
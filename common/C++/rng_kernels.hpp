@@ -0,0 +1,123 @@
+#ifndef RNG_KERNELS_HPP
+#define RNG_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "rng.hpp"
+
+// Internal: Philox + Box-Muller kernels. normal_pairs_body is written as
+// one flat loop over independent pairs, without calls to libm, so the
+// compiler vectorizes it for whatever -m flags its translation unit is
+// built with: every ISA file below just instantiates it. Only basic,
+// correctly rounded IEEE operations are used (no FMA contraction, see
+// CMakeLists.txt), hence all the kernels return bit-identical values.
+
+void normal_pairs_generic(uint64_t seed, uint64_t stream, uint64_t first_block, size_t pairs,
+                          double mean, double std, double *out);
+void normal_pairs_avx2(uint64_t seed, uint64_t stream, uint64_t first_block, size_t pairs,
+                       double mean, double std, double *out);
+void normal_pairs_avx512(uint64_t seed, uint64_t stream, uint64_t first_block, size_t pairs,
+                         double mean, double std, double *out);
+
+static inline double rng_from_bits(uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+static inline uint64_t rng_to_bits(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+// Exact conversion of an integer below 2^52, without cvt instructions
+// (AVX2 has none for 64-bit integers)
+static inline double rng_small_to_double(uint64_t i) {
+    return rng_from_bits(0x4330000000000000ull | i) - 0x1p52;
+}
+
+// log(u) for u in (0, 1]: u = m * 2^e with m in [sqrt(1/2), sqrt(2)),
+// log(m) = 2 atanh(s), s = (m - 1) / (m + 1), |s| < 0.172, as an odd
+// series (truncation error below 1e-19)
+static inline double rng_log(double u) {
+    const double SQRT2 = 1.4142135623730951;
+    const double LN2_HI = 0x1.62e42fefa3800p-1, LN2_LO = 0x1.ef35793c76730p-45;
+    uint64_t bits = rng_to_bits(u);
+    double e = rng_small_to_double(bits >> 52) - 1023.0;
+    double m = rng_from_bits((bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull);
+    bool high = m > SQRT2;
+    m = high ? 0.5 * m : m;
+    e = high ? e + 1.0 : e;
+
+    double s = (m - 1.0) / (m + 1.0);
+    double s2 = s * s;
+    double series = 1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7 + s2 * (1.0 / 9 + s2 * (1.0 / 11
+                  + s2 * (1.0 / 13 + s2 * (1.0 / 15 + s2 * (1.0 / 17 + s2 * (1.0 / 19 + s2 * (1.0 / 21)))))))));
+    double log_m = 2.0 * s + 2.0 * s * s2 * series;
+    return e * LN2_HI + (e * LN2_LO + log_m);
+}
+
+// sin and cos of 2*pi*u for u in [0, 1]: u = k/4 + x exactly, with k
+// an integer and |x| <= 1/8, then Taylor series on |2*pi*x| <= pi/4
+// (truncation error below 1e-19) and a quadrant rotation
+static inline void rng_sincos_turns(double u, double &sin_out, double &cos_out) {
+    const double TWO_PI_HI = 0x1.921fb54442d18p+2, TWO_PI_LO = 0x1.1a62633145c07p-52;
+    double k = (4.0 * u + 0x1.8p52) - 0x1.8p52; // round to nearest
+    double x = u - 0.25 * k;
+    double t = x * TWO_PI_HI + x * TWO_PI_LO;
+    double t2 = t * t;
+
+    double sin_t = t + t * t2 * (-1.0 / 6 + t2 * (1.0 / 120 + t2 * (-1.0 / 5040 + t2 * (1.0 / 362880
+                 + t2 * (-1.0 / 39916800 + t2 * (1.0 / 6227020800 + t2 * (-1.0 / 1307674368000
+                 + t2 * (1.0 / 355687428096000))))))));
+    double cos_t = 1.0 - 0.5 * t2 + t2 * t2 * (1.0 / 24 + t2 * (-1.0 / 720 + t2 * (1.0 / 40320
+                 + t2 * (-1.0 / 3628800 + t2 * (1.0 / 479001600 + t2 * (-1.0 / 87178291200
+                 + t2 * (1.0 / 20922789888000)))))));
+
+    // quadrant k mod 4 rotates (sin, cos) by k quarter turns
+    bool q1 = k == 1.0, q2 = k == 2.0, q3 = k == 3.0;
+    bool swap = q1 | q3;
+    double s = swap ? cos_t : sin_t;
+    double c = swap ? sin_t : cos_t;
+    sin_out = (q2 | q3) ? -s : s;
+    cos_out = (q1 | q2) ? -c : c;
+}
+
+static inline void normal_pairs_body(uint64_t seed, uint64_t stream, uint64_t first_block, size_t pairs,
+                                     double mean, double std, double *out) {
+    const uint32_t M0 = 0xd2511f53, M1 = 0xcd9e8d57;
+    const uint32_t W0 = 0x9e3779b9, W1 = 0xbb67ae85;
+    const uint32_t s0 = uint32_t(stream), s1 = uint32_t(stream >> 32);
+
+    for (size_t p = 0; p < pairs; p++) {
+        // Philox4x32-10, see philox4x32() in philox.hpp
+        uint64_t block = first_block + p;
+        uint32_t c0 = uint32_t(block), c1 = uint32_t(block >> 32), c2 = s0, c3 = s1;
+        uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = uint64_t(M0) * c0, p1 = uint64_t(M1) * c2;
+            uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+            c1 = uint32_t(p1);
+            c3 = uint32_t(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += W0;
+            k1 += W1;
+        }
+
+        // philox_uniform() of each half, then Box-Muller
+        double u1 = ((rng_small_to_double(c0) * 0x1p21 + rng_small_to_double(c1 >> 11)) + 0.5) * 0x1p-53;
+        double u2 = ((rng_small_to_double(c2) * 0x1p21 + rng_small_to_double(c3 >> 11)) + 0.5) * 0x1p-53;
+        double radius = __builtin_sqrt(-2.0 * rng_log(u1));
+        double s, c;
+        rng_sincos_turns(u2, s, c);
+        out[2 * p] = mean + std * (radius * c);
+        out[2 * p + 1] = mean + std * (radius * s);
+    }
+}
+
+#endif // RNG_KERNELS_HPP
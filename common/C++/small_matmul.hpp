@@ -0,0 +1,131 @@
+#ifndef SMALL_MATMUL_HPP
+#define SMALL_MATMUL_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+// Products of small matrices whose sizes are known at compile time,
+// C (N x K) = A (N x M) * B (M x K), all row-major and contiguous.
+// The templates below expand every dot product into straight-line code,
+// so there is no loop overhead left; build the caller with optimization
+// on, the expansion relies on inlining.
+
+// sum_{p < P} a[p] * b[p * stride_b], unrolled; a is strided by stride_a
+template <int P, size_t StrideA, size_t StrideB>
+struct SmallDot {
+    static inline double run(const double *a, const double *b) {
+        return SmallDot<P - 1, StrideA, StrideB>::run(a, b) + a[(P - 1) * StrideA] * b[(P - 1) * StrideB];
+    }
+};
+
+template <size_t StrideA, size_t StrideB>
+struct SmallDot<1, StrideA, StrideB> {
+    static inline double run(const double *a, const double *b) {
+        return a[0] * b[0];
+    }
+};
+
+// the first T elements of C, in row-major order
+template <int N, int M, int K, int T>
+struct SmallMatmulUnroll {
+    static inline void run(const double *a, const double *b, double *c) {
+        SmallMatmulUnroll<N, M, K, T - 1>::run(a, b, c);
+        const int i = (T - 1) / K, j = (T - 1) % K;
+        c[T - 1] = SmallDot<M, 1, K>::run(a + i * M, b + j);
+    }
+};
+
+template <int N, int M, int K>
+struct SmallMatmulUnroll<N, M, K, 0> {
+    static inline void run(const double *, const double *, double *) {}
+};
+
+// C = A * B for one N x M times M x K product, fully unrolled
+template <int N, int M, int K>
+inline void matmul(const double *a, const double *b, double *c) {
+    static_assert(N > 0 && M > 0 && K > 0, "empty matrices");
+    static_assert(N * M * K <= 4096, "matmul<N,M,K> is meant for small matrices, use dgemm");
+    SmallMatmulUnroll<N, M, K, N * K>::run(a, b, c);
+}
+
+// Batched layout: matrices are interleaved element by element in groups
+// of SMALL_MATMUL_LANES (AoSoA). Element e = i * cols + j of matrix l is
+//   soa[((l / SMALL_MATMUL_LANES) * rows * cols + e) * SMALL_MATMUL_LANES + l % SMALL_MATMUL_LANES]
+// Within a group the same element of consecutive matrices is adjacent,
+// so the loop over the batch is unit-stride and vectorizes, while each
+// group is one contiguous block that fits in L1 for small sizes.
+// The last group is padded; interleave_batch() zeroes the padding.
+const size_t SMALL_MATMUL_LANES = 32;
+
+// number of doubles needed to store count rows x cols matrices interleaved
+inline size_t batch_storage_size(size_t count, size_t rows, size_t cols) {
+    return (count + SMALL_MATMUL_LANES - 1) / SMALL_MATMUL_LANES * SMALL_MATMUL_LANES * rows * cols;
+}
+
+// All the lanes of one element of C. The results go through a local
+// buffer: it can not alias the operands, so the lane loop vectorizes
+// without runtime overlap checks.
+template <int M, int K>
+inline void small_dot_lanes(const double *ai, const double *bj, double *cij) {
+    const size_t L = SMALL_MATMUL_LANES;
+    double acc[L];
+    for (size_t l = 0; l < L; l++) {
+        acc[l] = SmallDot<M, L, K * L>::run(ai + l, bj + l);
+    }
+    std::copy(acc, acc + L, cij);
+}
+
+// the first T elements of C, for one group of matrices
+template <int N, int M, int K, int T>
+struct SmallMatmulBatchedUnroll {
+    static inline void run(const double *a, const double *b, double *c) {
+        SmallMatmulBatchedUnroll<N, M, K, T - 1>::run(a, b, c);
+        const size_t L = SMALL_MATMUL_LANES;
+        const int i = (T - 1) / K, j = (T - 1) % K;
+        small_dot_lanes<M, K>(a + i * M * L, b + j * L, c + (T - 1) * L);
+    }
+};
+
+template <int N, int M, int K>
+struct SmallMatmulBatchedUnroll<N, M, K, 0> {
+    static inline void run(const double *, const double *, double *) {}
+};
+
+// C_l = A_l * B_l for l < count, in the interleaved layout above
+// (a, b and c hold batch_storage_size() doubles)
+template <int N, int M, int K>
+void matmul_batched(size_t count, const double *a, const double *b, double *c) {
+    static_assert(N > 0 && M > 0 && K > 0, "empty matrices");
+    static_assert(N * M * K <= 4096, "matmul_batched<N,M,K> is meant for small matrices");
+
+    const size_t L = SMALL_MATMUL_LANES;
+    const size_t groups = (count + L - 1) / L;
+    for (size_t g = 0; g < groups; g++) {
+        SmallMatmulBatchedUnroll<N, M, K, N * K>::run(a + g * N * M * L, b + g * M * K * L, c + g * N * K * L);
+    }
+}
+
+// Conversions between count contiguous rows x cols matrices (AoS)
+// and the interleaved layout
+inline void interleave_batch(size_t count, size_t rows, size_t cols, const double *aos, double *soa) {
+    const size_t L = SMALL_MATMUL_LANES, size = rows * cols;
+    std::fill(soa + count / L * L * size, soa + batch_storage_size(count, rows, cols), 0.0);
+    for (size_t l = 0; l < count; l++) {
+        double *group = soa + l / L * size * L;
+        for (size_t e = 0; e < size; e++) {
+            group[e * L + l % L] = aos[l * size + e];
+        }
+    }
+}
+
+inline void deinterleave_batch(size_t count, size_t rows, size_t cols, const double *soa, double *aos) {
+    const size_t L = SMALL_MATMUL_LANES, size = rows * cols;
+    for (size_t l = 0; l < count; l++) {
+        const double *group = soa + l / L * size * L;
+        for (size_t e = 0; e < size; e++) {
+            aos[l * size + e] = group[e * L + l % L];
+        }
+    }
+}
+
+#endif // SMALL_MATMUL_HPP
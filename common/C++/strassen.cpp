@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include <new>
+
+#include "gemm.hpp"
+
+// Strassen-Winograd on square blocks: 7 half-size products and 15
+// additions per level instead of 8 products. Odd sizes are handled by
+// dynamic peeling: the even leading block recurses and the last row and
+// column are fixed up with plain dgemm calls.
+//
+// Memory-efficient schedule of Boyer, Dumas, Pernet and Zhou (2009):
+// besides C itself, each level only needs two h x h temporaries X and Y,
+// taken from a stack-like workspace arena, so the recursion never
+// allocates.
+
+// z = x + y and z = x - y on h x h strided blocks
+static void block_add(int h, const double *x, int ldx, const double *y, int ldy, double *z, int ldz) {
+    #pragma omp parallel for if(h >= 256)
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < h; j++) {
+            z[(size_t)i * ldz + j] = x[(size_t)i * ldx + j] + y[(size_t)i * ldy + j];
+        }
+    }
+}
+
+static void block_sub(int h, const double *x, int ldx, const double *y, int ldy, double *z, int ldz) {
+    #pragma omp parallel for if(h >= 256)
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < h; j++) {
+            z[(size_t)i * ldz + j] = x[(size_t)i * ldx + j] - y[(size_t)i * ldy + j];
+        }
+    }
+}
+
+size_t dgemm_strassen_workspace(int n, int cutoff) {
+    size_t size = 0;
+    while (n > cutoff && n >= 2) {
+        const int h = n / 2;
+        size += 2 * (size_t)h * h;
+        n = h;
+    }
+    return size;
+}
+
+static void strassen(int n, const double *a, int lda, const double *b, int ldb,
+                     double *c, int ldc, int cutoff, double *ws) {
+
+    if (n <= cutoff || n < 2) {
+        dgemm_parallel(n, n, n, 1.0, a, lda, b, ldb, 0.0, c, ldc);
+        return;
+    }
+
+    const int h = n / 2;
+    const int m = 2 * h; // even part, n - m is 0 or 1
+
+    const double *a11 = a, *a12 = a + h, *a21 = a + (size_t)h * lda, *a22 = a21 + h;
+    const double *b11 = b, *b12 = b + h, *b21 = b + (size_t)h * ldb, *b22 = b21 + h;
+    double *c11 = c, *c12 = c + h, *c21 = c + (size_t)h * ldc, *c22 = c21 + h;
+
+    double *x = ws, *y = ws + (size_t)h * h;
+    double *next = ws + 2 * (size_t)h * h;
+
+    block_sub(h, a11, lda, a21, lda, x, h);             // X = A11 - A21
+    block_sub(h, b22, ldb, b12, ldb, y, h);             // Y = B22 - B12
+    strassen(h, x, h, y, h, c21, ldc, cutoff, next);    // C21 = P7 = X * Y
+    block_add(h, a21, lda, a22, lda, x, h);             // X = A21 + A22
+    block_sub(h, b12, ldb, b11, ldb, y, h);             // Y = B12 - B11
+    strassen(h, x, h, y, h, c22, ldc, cutoff, next);    // C22 = P5 = X * Y
+    block_sub(h, x, h, a11, lda, x, h);                 // X = X - A11
+    block_sub(h, b22, ldb, y, h, y, h);                 // Y = B22 - Y
+    strassen(h, x, h, y, h, c12, ldc, cutoff, next);    // C12 = P6 = X * Y
+    block_sub(h, a12, lda, x, h, x, h);                 // X = A12 - X
+    strassen(h, x, h, b22, ldb, c11, ldc, cutoff, next); // C11 = P3 = X * B22
+    strassen(h, a11, lda, b11, ldb, x, h, cutoff, next); // X = P1 = A11 * B11
+    block_add(h, x, h, c12, ldc, c12, ldc);             // C12 = U2 = P1 + P6
+    block_add(h, c12, ldc, c21, ldc, c21, ldc);         // C21 = U3 = U2 + P7
+    block_add(h, c12, ldc, c22, ldc, c12, ldc);         // C12 = U4 = U2 + P5
+    block_add(h, c21, ldc, c22, ldc, c22, ldc);         // C22 = U7 = U3 + P5
+    block_add(h, c12, ldc, c11, ldc, c12, ldc);         // C12 = U5 = U4 + P3
+    block_sub(h, y, h, b21, ldb, y, h);                 // Y = T4 = Y - B21
+    strassen(h, a22, lda, y, h, c11, ldc, cutoff, next); // C11 = P4 = A22 * Y
+    block_sub(h, c21, ldc, c11, ldc, c21, ldc);         // C21 = U6 = U3 - P4
+    strassen(h, a12, lda, b21, ldb, c11, ldc, cutoff, next); // C11 = P2 = A12 * B21
+    block_add(h, x, h, c11, ldc, c11, ldc);             // C11 = U1 = P1 + P2
+
+    if (m < n) {
+        // peeling: C[:m, :m] += A[:m, m] * B[m, :m], then the last
+        // column and row of C from full dot products
+        dgemm(m, m, 1, 1.0, a + m, lda, b + (size_t)m * ldb, ldb, 1.0, c, ldc);
+        dgemm(m, 1, n, 1.0, a, lda, b + m, ldb, 0.0, c + m, ldc);
+        dgemm(1, n, n, 1.0, a + (size_t)m * lda, lda, b, ldb, 0.0, c + (size_t)m * ldc, ldc);
+    }
+}
+
+void dgemm_strassen(int n, const double *a, int lda, const double *b, int ldb,
+                    double *c, int ldc, int cutoff, double *workspace) {
+
+    if (n <= 0) {
+        return;
+    }
+    if (cutoff < 1) {
+        cutoff = 1;
+    }
+
+    // the whole recursion runs in one arena, sized up front
+    double *arena = workspace;
+    if (arena == nullptr) {
+        const size_t size = dgemm_strassen_workspace(n, cutoff);
+        if (size > 0 && posix_memalign(reinterpret_cast<void **>(&arena), 64, size * sizeof(double)) != 0) {
+            throw std::bad_alloc();
+        }
+    }
+
+    strassen(n, a, lda, b, ldb, c, ldc, cutoff, arena);
+
+    if (workspace == nullptr) {
+        free(arena);
+    }
+}
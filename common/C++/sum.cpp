@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "sum.hpp"
+#include "sum_kernels.hpp"
+
+CompensatedSum KahanBabushkaNeumaierSum_scalar(const double *vec, int n) {
+    /*
+    Kahan-Babushka-Neumaier summation algorithm
+    This algorithm is a modification of the Kahan summation algorithm that uses two variables
+    to keep track of the compensation for lost low-order bits.
+    */
+
+    double sum = 0.0, c = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        double t = sum + vec[i];
+        if (std::fabs(sum) >= std::fabs(vec[i])) {
+            c += (sum - t) + vec[i]; // c is the compensation for low-order bits lost from vec[i]
+        } else {
+            c += (vec[i] - t) + sum; // c is the compensation for low-order bits lost from sum
+        }
+        sum = t;
+    }
+    return {sum, c};
+}
+
+kbn_kernel_t kbn_kernel(Isa isa) {
+    if (!isa_supported(isa)) {
+        return nullptr;
+    }
+
+    switch (isa) {
+#if defined(SC4PS_HAVE_SSE2)
+    case Isa::SSE2:
+        return kbn_sum_sse2;
+#endif
+#if defined(SC4PS_HAVE_AVX2)
+    case Isa::AVX2:
+        return kbn_sum_avx2;
+#endif
+#if defined(SC4PS_HAVE_AVX512)
+    case Isa::AVX512:
+        return kbn_sum_avx512;
+#endif
+    default:
+        return KahanBabushkaNeumaierSum_scalar;
+    }
+}
+
+Isa sum_selected_isa() {
+    static const Isa isa = isa_select("SC4PS_SUM_ISA");
+    return isa;
+}
+
+CompensatedSum KahanBabushkaNeumaierSum_partial(const double *vec, int n) {
+    static const kbn_kernel_t kernel = kbn_kernel(sum_selected_isa());
+
+    if (n <= 0) {
+        return {0.0, 0.0};
+    }
+    return kernel(vec, n);
+}
+
+double KahanBabushkaNeumaierSum(const double *vec, int n) {
+    CompensatedSum s = KahanBabushkaNeumaierSum_partial(vec, n);
+    return s.sum + s.c;
+}
+
+CompensatedSum KahanBabushkaNeumaierSum_parallel_partial(const double *vec, int n) {
+    /*
+    The blocks, not the threads, define how the sum is split: threads
+    only decide who computes which block sum, so the values merged and
+    the order of the merges never depend on the thread count.
+    */
+    if (n <= KBN_PARALLEL_BLOCK) {
+        return KahanBabushkaNeumaierSum_partial(vec, n);
+    }
+
+    const int blocks = (n + KBN_PARALLEL_BLOCK - 1) / KBN_PARALLEL_BLOCK;
+    std::vector<CompensatedSum> partial(blocks);
+
+    #pragma omp parallel for schedule(static)
+    for (int b = 0; b < blocks; b++) {
+        int start = b * KBN_PARALLEL_BLOCK;
+        partial[b] = KahanBabushkaNeumaierSum_partial(vec + start, std::min(KBN_PARALLEL_BLOCK, n - start));
+    }
+    return compensated_merge_pairwise(partial.data(), blocks);
+}
+
+CompensatedSum compensated_merge_pairwise(CompensatedSum *partial, int blocks) {
+    if (blocks <= 0) {
+        return {0.0, 0.0};
+    }
+
+    // pairwise merge tree, one level at a time: partial[b] absorbs
+    // partial[b + width]
+    for (int width = 1; width < blocks; width *= 2) {
+        #pragma omp parallel for schedule(static) if(blocks / width >= 4096)
+        for (int b = 0; b < blocks - width; b += 2 * width) {
+            partial[b] = compensated_merge(partial[b], partial[b + width]);
+        }
+    }
+    return partial[0];
+}
+
+double KahanBabushkaNeumaierSum_parallel(const double *vec, int n) {
+    CompensatedSum s = KahanBabushkaNeumaierSum_parallel_partial(vec, n);
+    return s.sum + s.c;
+}
+
+const char *sum_method_name(SumMethod method) {
+    switch (method) {
+    case SumMethod::Reproducible:
+        return "reproducible";
+    case SumMethod::Exact:
+        return "exact";
+    default:
+        return "kbn";
+    }
+}
+
+bool sum_method_from_name(const char *name, SumMethod &method) {
+    for (SumMethod m : {SumMethod::KBN, SumMethod::Reproducible, SumMethod::Exact}) {
+        if (strcmp(name, sum_method_name(m)) == 0) {
+            method = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+double sum_with(SumMethod method, const double *vec, int n) {
+    switch (method) {
+    case SumMethod::Reproducible:
+        return ReproducibleSum(vec, n);
+    case SumMethod::Exact:
+        return ExactSum(vec, n);
+    default:
+        return KahanBabushkaNeumaierSum(vec, n);
+    }
+}
+
+double sum_with_parallel(SumMethod method, const double *vec, int n) {
+    switch (method) {
+    case SumMethod::Reproducible:
+        return ReproducibleSum_parallel(vec, n);
+    case SumMethod::Exact:
+        return ExactSum_parallel(vec, n);
+    default:
+        return KahanBabushkaNeumaierSum_parallel(vec, n);
+    }
+}
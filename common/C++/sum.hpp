@@ -0,0 +1,175 @@
+#ifndef SUM_HPP
+#define SUM_HPP
+
+#include <cstdint>
+
+#include "isa.hpp"
+
+// Accurate summation kernels.
+
+// An unevaluated sum: the value is sum + c, c holding the rounding
+// errors made while accumulating sum.
+struct CompensatedSum {
+    double sum;
+    double c;
+};
+
+// Knuth's TwoSum, branch free: s + e == a + b exactly, s = fl(a + b).
+// Needs strict IEEE evaluation (no -ffast-math, no FMA contraction).
+inline CompensatedSum two_sum(double a, double b) {
+    double s = a + b;
+    double bp = s - a;
+    double e = (a - (s - bp)) + (b - bp);
+    return {s, e};
+}
+
+// Adds x to acc (one Kahan-Babushka-Neumaier step)
+inline void compensated_add(CompensatedSum &acc, double x) {
+    CompensatedSum t = two_sum(acc.sum, x);
+    acc.sum = t.sum;
+    acc.c += t.c;
+}
+
+// Merges two partial compensated sums: the leading parts are added
+// exactly with TwoSum, the compensations on top
+inline CompensatedSum compensated_merge(CompensatedSum a, CompensatedSum b) {
+    CompensatedSum t = two_sum(a.sum, b.sum);
+    return {t.sum, t.c + (a.c + b.c)};
+}
+
+// OpenMP reduction over CompensatedSum, e.g.
+//     CompensatedSum total = {0.0, 0.0};
+//     #pragma omp parallel for reduction(compensated_merge: total)
+// Every thread accumulates its own (sum, c) pair and the pairs are
+// combined with compensated_merge, keeping the KBN error bound. The
+// order in which OpenMP combines them is unspecified, so the last bit
+// can change with the number of threads: use
+// KahanBabushkaNeumaierSum_parallel, or compensated_merge_pairwise on
+// per-block sums, when that matters.
+#ifdef _OPENMP
+#pragma omp declare reduction(compensated_merge : CompensatedSum : omp_out = compensated_merge(omp_out, omp_in)) \
+    initializer(omp_priv = CompensatedSum{0.0, 0.0})
+#endif
+
+typedef CompensatedSum (*kbn_kernel_t)(const double *vec, int n);
+
+// Kahan-Babushka-Neumaier sum of vec[0..n) with the best kernel for this
+// host. The SIMD kernels keep an independent (sum, c) pair per vector
+// lane and register, updated with branch-free TwoSum, and merge the
+// lanes with compensated_merge at the end, so they are as accurate as
+// the scalar algorithm but run at memory bandwidth. The lanes change the
+// order of the additions, hence the last bit can differ between kernels.
+double KahanBabushkaNeumaierSum(const double *vec, int n);
+
+// Same, without the final rounding of sum + c, e.g. to merge partial
+// sums computed by different threads
+CompensatedSum KahanBabushkaNeumaierSum_partial(const double *vec, int n);
+
+// Multithreaded with OpenMP and reproducible: vec is cut in blocks of
+// KBN_PARALLEL_BLOCK elements, whatever the number of threads, each
+// block is summed with the SIMD kernel and the block sums are merged
+// along a fixed pairwise tree. The result is bit-identical for any
+// OMP_NUM_THREADS (on a given ISA) and as accurate as the serial sum.
+const int KBN_PARALLEL_BLOCK = 1 << 14;
+double KahanBabushkaNeumaierSum_parallel(const double *vec, int n);
+CompensatedSum KahanBabushkaNeumaierSum_parallel_partial(const double *vec, int n);
+
+// The merge of KahanBabushkaNeumaierSum_parallel: partial[0..blocks)
+// combined along a fixed pairwise tree, so the result depends on the
+// block sums only, not on the threads that computed them. Overwrites
+// partial; {0, 0} for no blocks.
+CompensatedSum compensated_merge_pairwise(CompensatedSum *partial, int blocks);
+
+// Reproducible summation (binned, after Demmel & Nguyen / ReproBLAS).
+// Every value is split, exactly, along a fixed grid of bins of
+// BINNED_WIDTH bits and only the BINNED_FOLD bins below the largest
+// magnitude seen are kept: each bin adds integer multiples of its own
+// ulp, without rounding. The state therefore depends on the values
+// summed but not on their order, nor on how they were split between
+// calls, threads, ranks or SIMD lanes: the sum is bit-identical for any
+// decomposition and any ISA. With 3 bins of 40 bits the error is below
+// about 2^-80 * max|x| * n, better than KBN on all but tiny inputs.
+// Infinities and NaN propagate; magnitudes of 2^1004 and more are added
+// naively (not reproducibly) since their bins would overflow.
+const int BINNED_FOLD = 3;
+const int BINNED_WIDTH = 40;
+
+struct BinnedSum {
+    int top;                        // index of the highest bin, -1 when empty
+    double primary[BINNED_FOLD];    // bin top - k, offset by 1.5 * 2^52 ulp
+    double carry[BINNED_FOLD];      // multiples of 2^50 ulp moved out of primary
+    double special;                 // inf, nan and out of range values
+    int deposits;                   // scalar deposits since the last renormalization
+};
+
+void binned_sum_clear(BinnedSum &s);
+void binned_sum_add(BinnedSum &s, const double *vec, int n);
+// a += b; exact, hence associative and commutative
+void binned_sum_merge(BinnedSum &a, const BinnedSum &b);
+// Rounds the state to a double, the same way for equal states
+double binned_sum_value(const BinnedSum &s);
+
+// OpenMP reduction over BinnedSum: since merges are exact, the thread
+// count and the order of the combination do not change the result
+#ifdef _OPENMP
+#pragma omp declare reduction(binned_merge : BinnedSum : binned_sum_merge(omp_out, omp_in)) \
+    initializer(binned_sum_clear(omp_priv))
+#endif
+
+double ReproducibleSum(const double *vec, int n);
+// Multithreaded with OpenMP, bit-identical to ReproducibleSum
+double ReproducibleSum_parallel(const double *vec, int n);
+
+// Exact summation (superaccumulator). Every double is an integer
+// multiple of 2^-1074 below 2^1024, so a fixed-point number of 2176 bits
+// (68 limbs of 32 bits, the spare high bits of each int64 limb taking the
+// carries) holds any sum exactly; additions are integer additions to at
+// most three limbs, with no rounding at all, and only the final value is
+// rounded, correctly (to nearest, ties to even). The result is thus the
+// exact sum rounded once, whatever the order, the split or the
+// conditioning; the accumulator stays in L1 cache.
+// Infinities and NaN propagate as in IEEE arithmetic.
+const int SUPERACC_LIMBS = 68;
+
+struct SuperAccumulator {
+    int64_t limb[SUPERACC_LIMBS];   // limb i: multiples of 2^(32 i - 1074)
+    double special;                 // inf and nan
+    int adds;                       // additions since the last carry propagation
+};
+
+void superacc_clear(SuperAccumulator &s);
+void superacc_add(SuperAccumulator &s, const double *vec, int n);
+// a += b, exact
+void superacc_merge(SuperAccumulator &a, const SuperAccumulator &b);
+// The sum, correctly rounded
+double superacc_value(const SuperAccumulator &s);
+
+#ifdef _OPENMP
+#pragma omp declare reduction(superacc_merge : SuperAccumulator : superacc_merge(omp_out, omp_in)) \
+    initializer(superacc_clear(omp_priv))
+#endif
+
+double ExactSum(const double *vec, int n);
+// Multithreaded with OpenMP, same result
+double ExactSum_parallel(const double *vec, int n);
+
+// Summation methods, for the programs that let the user pick one:
+// kbn (fastest), reproducible (binned) or exact
+enum class SumMethod { KBN = 0, Reproducible, Exact };
+
+const char *sum_method_name(SumMethod method);
+// false if name is none of the above
+bool sum_method_from_name(const char *name, SumMethod &method);
+double sum_with(SumMethod method, const double *vec, int n);
+double sum_with_parallel(SumMethod method, const double *vec, int n);
+
+// The classic branchy scalar loop, kept as a reference
+CompensatedSum KahanBabushkaNeumaierSum_scalar(const double *vec, int n);
+
+// Introspection, mostly for benchmarks and tests.
+// The selection can be forced with the environment variable
+// SC4PS_SUM_ISA=scalar|sse2|avx2|avx512 (ignored if unsupported).
+Isa sum_selected_isa();
+kbn_kernel_t kbn_kernel(Isa isa); // nullptr if not supported
+
+#endif // SUM_HPP
@@ -0,0 +1,155 @@
+#include <cmath>
+#include <immintrin.h>
+
+#include "sum_kernels.hpp"
+
+// TwoSum of (s, x) in every lane, the rounding error goes into c
+static inline void kbn_step(__m256d &s, __m256d &c, __m256d x) {
+    __m256d t = _mm256_add_pd(s, x);
+    __m256d bp = _mm256_sub_pd(t, s);
+    __m256d e = _mm256_add_pd(_mm256_sub_pd(s, _mm256_sub_pd(t, bp)), _mm256_sub_pd(x, bp));
+    c = _mm256_add_pd(c, e);
+    s = t;
+}
+
+// 4 doubles per register, 4 independent (sum, c) pairs per iteration
+CompensatedSum kbn_sum_avx2(const double *vec, int n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    __m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd(), c2 = _mm256_setzero_pd(), c3 = _mm256_setzero_pd();
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        kbn_step(s0, c0, _mm256_loadu_pd(vec + i));
+        kbn_step(s1, c1, _mm256_loadu_pd(vec + i + 4));
+        kbn_step(s2, c2, _mm256_loadu_pd(vec + i + 8));
+        kbn_step(s3, c3, _mm256_loadu_pd(vec + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) {
+        kbn_step(s0, c0, _mm256_loadu_pd(vec + i));
+    }
+
+    double sums[16], cs[16];
+    _mm256_storeu_pd(sums, s0);
+    _mm256_storeu_pd(sums + 4, s1);
+    _mm256_storeu_pd(sums + 8, s2);
+    _mm256_storeu_pd(sums + 12, s3);
+    _mm256_storeu_pd(cs, c0);
+    _mm256_storeu_pd(cs + 4, c1);
+    _mm256_storeu_pd(cs + 8, c2);
+    _mm256_storeu_pd(cs + 12, c3);
+
+    // merge the lanes, then the remainder
+    return kbn_merge_lanes(sums, cs, 16, vec + i, n - i);
+}
+
+
+// One element of the fused daxpy and reduction: y = a*x + y, then the new
+// y into the sum and, with STATS, the sum of squares, minimum and maximum
+template <bool STATS>
+static inline void fused_step(__m256d &s, __m256d &c, __m256d &q, __m256d &d, __m256d &lo, __m256d &hi,
+                              __m256d va, bool axpy, const double *x, double *y) {
+    __m256d v = _mm256_loadu_pd(y);
+    if (axpy) {
+        v = _mm256_add_pd(v, _mm256_mul_pd(va, _mm256_loadu_pd(x)));
+        _mm256_storeu_pd(y, v);
+    }
+    kbn_step(s, c, v);
+    if (STATS) {
+        kbn_step(q, d, _mm256_mul_pd(v, v));
+        lo = _mm256_min_pd(lo, v);
+        hi = _mm256_max_pd(hi, v);
+    }
+}
+
+// 4 doubles per register, 4 registers per iteration as in kbn_sum_avx2
+template <bool STATS>
+static DaxpyReduction fused_avx2(int n, double a, const double *x, double *y) {
+    const bool axpy = a != 0.0;
+    const __m256d va = _mm256_set1_pd(a);
+    __m256d s[4], c[4], q[4], d[4];
+    for (int k = 0; k < 4; k++) {
+        s[k] = c[k] = q[k] = d[k] = _mm256_setzero_pd();
+    }
+    __m256d lo = _mm256_set1_pd(INFINITY), hi = _mm256_set1_pd(-INFINITY);
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (int k = 0; k < 4; k++) {
+            fused_step<STATS>(s[k], c[k], q[k], d[k], lo, hi, va, axpy, x + i + 4 * k, y + i + 4 * k);
+        }
+    }
+    for (; i + 4 <= n; i += 4) {
+        fused_step<STATS>(s[0], c[0], q[0], d[0], lo, hi, va, axpy, x + i, y + i);
+    }
+
+    // remainder, as in daxpy_avx2
+    if (axpy) {
+        for (int j = i; j < n; j++) {
+            y[j] += a * x[j];
+        }
+    }
+
+    // short vectors (small chunks) only touched the first register
+    const int regs = n >= 16 ? 4 : 1;
+    double sums[16], cs[16], sq_sums[16], sq_cs[16], mins[4], maxs[4];
+    for (int k = 0; k < regs; k++) {
+        _mm256_storeu_pd(sums + 4 * k, s[k]);
+        _mm256_storeu_pd(cs + 4 * k, c[k]);
+        _mm256_storeu_pd(sq_sums + 4 * k, q[k]);
+        _mm256_storeu_pd(sq_cs + 4 * k, d[k]);
+    }
+    _mm256_storeu_pd(mins, lo);
+    _mm256_storeu_pd(maxs, hi);
+
+    if (STATS) {
+        return daxpy_merge_lanes(sums, cs, sq_sums, sq_cs, 4 * regs, mins, maxs, 4, y + i, n - i);
+    }
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    r.sum = kbn_merge_lanes(sums, cs, 4 * regs, y + i, n - i);
+    return r;
+}
+
+CompensatedSum daxpy_sum_avx2(int n, double a, const double *x, double *y) {
+    return fused_avx2<false>(n, a, x, y).sum;
+}
+
+DaxpyReduction daxpy_reduce_avx2(int n, double a, const double *x, double *y) {
+    return fused_avx2<true>(n, a, x, y);
+}
+
+
+// One deposit step: the part of r on the grid of p goes to p, r keeps the rest
+static inline void binned_step(__m256d &p, __m256d &r, __m256d lsb) {
+    __m256d q = _mm256_add_pd(p, _mm256_or_pd(r, lsb));
+    r = _mm256_sub_pd(r, _mm256_sub_pd(q, p));
+    p = q;
+}
+
+// 4 lanes per register, 2 registers per bin
+void binned_deposit_avx2(double (*primary)[BINNED_LANES], const uint64_t *lsb, const double *vec, int n) {
+    const __m256d lsb0 = _mm256_castsi256_pd(_mm256_set1_epi64x(lsb[0]));
+    const __m256d lsb1 = _mm256_castsi256_pd(_mm256_set1_epi64x(lsb[1]));
+    const __m256d lsb2 = _mm256_castsi256_pd(_mm256_set1_epi64x(lsb[2]));
+    __m256d p0a = _mm256_loadu_pd(primary[0]), p1a = _mm256_loadu_pd(primary[1]), p2a = _mm256_loadu_pd(primary[2]);
+    __m256d p0b = _mm256_loadu_pd(primary[0] + 4), p1b = _mm256_loadu_pd(primary[1] + 4), p2b = _mm256_loadu_pd(primary[2] + 4);
+
+    for (int i = 0; i < n; i += BINNED_LANES) {
+        __m256d ra = _mm256_loadu_pd(vec + i);
+        __m256d rb = _mm256_loadu_pd(vec + i + 4);
+        binned_step(p0a, ra, lsb0);
+        binned_step(p0b, rb, lsb0);
+        binned_step(p1a, ra, lsb1);
+        binned_step(p1b, rb, lsb1);
+        // the rest, below the last bin, is dropped
+        p2a = _mm256_add_pd(p2a, _mm256_or_pd(ra, lsb2));
+        p2b = _mm256_add_pd(p2b, _mm256_or_pd(rb, lsb2));
+    }
+
+    _mm256_storeu_pd(primary[0], p0a);
+    _mm256_storeu_pd(primary[1], p1a);
+    _mm256_storeu_pd(primary[2], p2a);
+    _mm256_storeu_pd(primary[0] + 4, p0b);
+    _mm256_storeu_pd(primary[1] + 4, p1b);
+    _mm256_storeu_pd(primary[2] + 4, p2b);
+}
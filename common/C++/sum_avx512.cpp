@@ -0,0 +1,149 @@
+#include <cmath>
+#include <immintrin.h>
+
+#include "sum_kernels.hpp"
+
+// TwoSum of (s, x) in every lane, the rounding error goes into c
+static inline void kbn_step(__m512d &s, __m512d &c, __m512d x) {
+    __m512d t = _mm512_add_pd(s, x);
+    __m512d bp = _mm512_sub_pd(t, s);
+    __m512d e = _mm512_add_pd(_mm512_sub_pd(s, _mm512_sub_pd(t, bp)), _mm512_sub_pd(x, bp));
+    c = _mm512_add_pd(c, e);
+    s = t;
+}
+
+// 8 doubles per register, 4 independent (sum, c) pairs per iteration
+CompensatedSum kbn_sum_avx512(const double *vec, int n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd(), s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd(), c3 = _mm512_setzero_pd();
+
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        kbn_step(s0, c0, _mm512_loadu_pd(vec + i));
+        kbn_step(s1, c1, _mm512_loadu_pd(vec + i + 8));
+        kbn_step(s2, c2, _mm512_loadu_pd(vec + i + 16));
+        kbn_step(s3, c3, _mm512_loadu_pd(vec + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) {
+        kbn_step(s0, c0, _mm512_loadu_pd(vec + i));
+    }
+
+    double sums[32], cs[32];
+    _mm512_storeu_pd(sums, s0);
+    _mm512_storeu_pd(sums + 8, s1);
+    _mm512_storeu_pd(sums + 16, s2);
+    _mm512_storeu_pd(sums + 24, s3);
+    _mm512_storeu_pd(cs, c0);
+    _mm512_storeu_pd(cs + 8, c1);
+    _mm512_storeu_pd(cs + 16, c2);
+    _mm512_storeu_pd(cs + 24, c3);
+
+    // merge the lanes, then the remainder
+    return kbn_merge_lanes(sums, cs, 32, vec + i, n - i);
+}
+
+
+// One element of the fused daxpy and reduction: y = a*x + y, then the new
+// y into the sum and, with STATS, the sum of squares, minimum and maximum
+template <bool STATS>
+static inline void fused_step(__m512d &s, __m512d &c, __m512d &q, __m512d &d, __m512d &lo, __m512d &hi,
+                              __m512d va, bool axpy, const double *x, double *y) {
+    __m512d v = _mm512_loadu_pd(y);
+    if (axpy) {
+        v = _mm512_add_pd(v, _mm512_mul_pd(va, _mm512_loadu_pd(x)));
+        _mm512_storeu_pd(y, v);
+    }
+    kbn_step(s, c, v);
+    if (STATS) {
+        kbn_step(q, d, _mm512_mul_pd(v, v));
+        // the masked forms: the plain ones start from _mm512_undefined_pd(),
+        // which GCC reports as maybe uninitialized
+        lo = _mm512_mask_min_pd(lo, 0xFF, lo, v);
+        hi = _mm512_mask_max_pd(hi, 0xFF, hi, v);
+    }
+}
+
+// 8 doubles per register, 4 registers per iteration as in kbn_sum_avx512
+template <bool STATS>
+static DaxpyReduction fused_avx512(int n, double a, const double *x, double *y) {
+    const bool axpy = a != 0.0;
+    const __m512d va = _mm512_set1_pd(a);
+    __m512d s[4], c[4], q[4], d[4];
+    for (int k = 0; k < 4; k++) {
+        s[k] = c[k] = q[k] = d[k] = _mm512_setzero_pd();
+    }
+    __m512d lo = _mm512_set1_pd(INFINITY), hi = _mm512_set1_pd(-INFINITY);
+
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int k = 0; k < 4; k++) {
+            fused_step<STATS>(s[k], c[k], q[k], d[k], lo, hi, va, axpy, x + i + 8 * k, y + i + 8 * k);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        fused_step<STATS>(s[0], c[0], q[0], d[0], lo, hi, va, axpy, x + i, y + i);
+    }
+
+    // remainder, as in daxpy_avx512
+    if (axpy) {
+        for (int j = i; j < n; j++) {
+            y[j] += a * x[j];
+        }
+    }
+
+    // short vectors (small chunks) only touched the first register
+    const int regs = n >= 32 ? 4 : 1;
+    double sums[32], cs[32], sq_sums[32], sq_cs[32], mins[8], maxs[8];
+    for (int k = 0; k < regs; k++) {
+        _mm512_storeu_pd(sums + 8 * k, s[k]);
+        _mm512_storeu_pd(cs + 8 * k, c[k]);
+        _mm512_storeu_pd(sq_sums + 8 * k, q[k]);
+        _mm512_storeu_pd(sq_cs + 8 * k, d[k]);
+    }
+    _mm512_storeu_pd(mins, lo);
+    _mm512_storeu_pd(maxs, hi);
+
+    if (STATS) {
+        return daxpy_merge_lanes(sums, cs, sq_sums, sq_cs, 8 * regs, mins, maxs, 8, y + i, n - i);
+    }
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    r.sum = kbn_merge_lanes(sums, cs, 8 * regs, y + i, n - i);
+    return r;
+}
+
+CompensatedSum daxpy_sum_avx512(int n, double a, const double *x, double *y) {
+    return fused_avx512<false>(n, a, x, y).sum;
+}
+
+DaxpyReduction daxpy_reduce_avx512(int n, double a, const double *x, double *y) {
+    return fused_avx512<true>(n, a, x, y);
+}
+
+
+// One deposit step: the part of r on the grid of p goes to p, r keeps the rest
+static inline void binned_step(__m512d &p, __m512d &r, __m512i lsb) {
+    __m512d q = _mm512_add_pd(p, _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(r), lsb)));
+    r = _mm512_sub_pd(r, _mm512_sub_pd(q, p));
+    p = q;
+}
+
+// 8 lanes per register, 1 register per bin
+void binned_deposit_avx512(double (*primary)[BINNED_LANES], const uint64_t *lsb, const double *vec, int n) {
+    const __m512i lsb0 = _mm512_set1_epi64(lsb[0]);
+    const __m512i lsb1 = _mm512_set1_epi64(lsb[1]);
+    const __m512i lsb2 = _mm512_set1_epi64(lsb[2]);
+    __m512d p0 = _mm512_loadu_pd(primary[0]), p1 = _mm512_loadu_pd(primary[1]), p2 = _mm512_loadu_pd(primary[2]);
+
+    for (int i = 0; i < n; i += BINNED_LANES) {
+        __m512d r = _mm512_loadu_pd(vec + i);
+        binned_step(p0, r, lsb0);
+        binned_step(p1, r, lsb1);
+        // the rest, below the last bin, is dropped
+        p2 = _mm512_add_pd(p2, _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(r), lsb2)));
+    }
+
+    _mm512_storeu_pd(primary[0], p0);
+    _mm512_storeu_pd(primary[1], p1);
+    _mm512_storeu_pd(primary[2], p2);
+}
@@ -0,0 +1,91 @@
+#ifndef SUM_KERNELS_HPP
+#define SUM_KERNELS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "daxpy_sum.hpp"
+#include "sum.hpp"
+
+// Internal: ISA-specific kernels, each one lives in its own translation
+// unit compiled with the matching -m flags. Only call them after checking
+// the CPU supports the instruction set (see sum.cpp).
+
+CompensatedSum kbn_sum_sse2(const double *vec, int n);
+CompensatedSum kbn_sum_avx2(const double *vec, int n);
+CompensatedSum kbn_sum_avx512(const double *vec, int n);
+
+// Merges the per-lane (sum, c) pairs of the SIMD kernels and adds the
+// tail vec[0..n) that did not fill a whole register
+inline CompensatedSum kbn_merge_lanes(const double *sums, const double *cs, int lanes, const double *vec, int n) {
+    CompensatedSum acc = {0.0, 0.0};
+    for (int l = 0; l < lanes; l++) {
+        // lanes left empty by short vectors add nothing, not even a
+        // rounding (lane sums start at +0, so they are never -0)
+        if (sums[l] != 0.0 || cs[l] != 0.0) {
+            acc = compensated_merge(acc, {sums[l], cs[l]});
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        compensated_add(acc, vec[i]);
+    }
+    return acc;
+}
+
+// Fused daxpy and KBN sum (see daxpy_sum.hpp): the lanes, registers and
+// remainder of the kbn_sum_* kernels of the same ISA, the remainder of y
+// updated as in the daxpy kernels. a == 0 leaves y alone.
+CompensatedSum daxpy_sum_sse2(int n, double a, const double *x, double *y);
+CompensatedSum daxpy_sum_avx2(int n, double a, const double *x, double *y);
+CompensatedSum daxpy_sum_avx512(int n, double a, const double *x, double *y);
+DaxpyReduction daxpy_reduce_sse2(int n, double a, const double *x, double *y);
+DaxpyReduction daxpy_reduce_avx2(int n, double a, const double *x, double *y);
+DaxpyReduction daxpy_reduce_avx512(int n, double a, const double *x, double *y);
+
+// Merges the per-lane results of the daxpy_reduce kernels, sums and
+// sums of squares in lanes (as kbn_merge_lanes), minima and maxima in
+// minmax_lanes, and adds the tail y[0..n), already updated
+inline DaxpyReduction daxpy_merge_lanes(const double *sums, const double *cs, const double *sq_sums,
+                                        const double *sq_cs, int lanes, const double *mins,
+                                        const double *maxs, int minmax_lanes, const double *y, int n) {
+    DaxpyReduction r;
+    r.sum = kbn_merge_lanes(sums, cs, lanes, y, n);
+    // the squares of the tail are added below, with the minima and maxima
+    r.sum_sq = kbn_merge_lanes(sq_sums, sq_cs, lanes, y, 0);
+    r.min = INFINITY;
+    r.max = -INFINITY;
+    for (int l = 0; l < minmax_lanes; l++) {
+        r.min = std::min(r.min, mins[l]);
+        r.max = std::max(r.max, maxs[l]);
+    }
+    for (int i = 0; i < n; i++) {
+        compensated_add(r.sum_sq, y[i] * y[i]);
+        r.min = std::min(r.min, y[i]);
+        r.max = std::max(r.max, y[i]);
+    }
+    return r;
+}
+
+// Binned deposit: BINNED_LANES independent copies of the primaries, one
+// per lane, so that the loop vectorizes; the lanes are folded into the
+// BinnedSum exactly afterwards (see binned_sum.cpp).
+const int BINNED_LANES = 8;
+
+// Splits vec[0..n), n a multiple of BINNED_LANES, into the bins: the
+// primary p of a bin with ulp u lies in [2^52 u, 2^53 u), so fl(p + r)
+// rounds r to a multiple of u and the part taken, q - p, is exact, as is
+// the rest r - (q - p) passed to the next bin. Forcing the last bit of r
+// to 1 (lsb[k] = 1) rules out rounding ties, whose result would depend
+// on the last bit of p, i.e. on what was added before. lsb[k] is 0 for
+// the lowest bin, ulp 2^-1074, where every addition is exact anyway.
+// Lane j takes the elements j, j + BINNED_LANES, ... in every kernel,
+// which all do the same IEEE operations: the results are bit-identical.
+typedef void (*binned_deposit_t)(double (*primary)[BINNED_LANES], const uint64_t *lsb,
+                                 const double *vec, int n);
+
+void binned_deposit_generic(double (*primary)[BINNED_LANES], const uint64_t *lsb, const double *vec, int n);
+void binned_deposit_avx2(double (*primary)[BINNED_LANES], const uint64_t *lsb, const double *vec, int n);
+void binned_deposit_avx512(double (*primary)[BINNED_LANES], const uint64_t *lsb, const double *vec, int n);
+
+#endif // SUM_KERNELS_HPP
@@ -0,0 +1,118 @@
+#include <cmath>
+#include <emmintrin.h>
+
+#include "sum_kernels.hpp"
+
+// TwoSum of (s, x) in every lane, the rounding error goes into c
+static inline void kbn_step(__m128d &s, __m128d &c, __m128d x) {
+    __m128d t = _mm_add_pd(s, x);
+    __m128d bp = _mm_sub_pd(t, s);
+    __m128d e = _mm_add_pd(_mm_sub_pd(s, _mm_sub_pd(t, bp)), _mm_sub_pd(x, bp));
+    c = _mm_add_pd(c, e);
+    s = t;
+}
+
+// 2 doubles per register, 4 independent (sum, c) pairs per iteration
+CompensatedSum kbn_sum_sse2(const double *vec, int n) {
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+    __m128d c0 = _mm_setzero_pd(), c1 = _mm_setzero_pd(), c2 = _mm_setzero_pd(), c3 = _mm_setzero_pd();
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        kbn_step(s0, c0, _mm_loadu_pd(vec + i));
+        kbn_step(s1, c1, _mm_loadu_pd(vec + i + 2));
+        kbn_step(s2, c2, _mm_loadu_pd(vec + i + 4));
+        kbn_step(s3, c3, _mm_loadu_pd(vec + i + 6));
+    }
+    for (; i + 2 <= n; i += 2) {
+        kbn_step(s0, c0, _mm_loadu_pd(vec + i));
+    }
+
+    double sums[8], cs[8];
+    _mm_storeu_pd(sums, s0);
+    _mm_storeu_pd(sums + 2, s1);
+    _mm_storeu_pd(sums + 4, s2);
+    _mm_storeu_pd(sums + 6, s3);
+    _mm_storeu_pd(cs, c0);
+    _mm_storeu_pd(cs + 2, c1);
+    _mm_storeu_pd(cs + 4, c2);
+    _mm_storeu_pd(cs + 6, c3);
+
+    // merge the lanes, then the remainder
+    return kbn_merge_lanes(sums, cs, 8, vec + i, n - i);
+}
+
+// One element of the fused daxpy and reduction: y = a*x + y, then the new
+// y into the sum and, with STATS, the sum of squares, minimum and maximum
+template <bool STATS>
+static inline void fused_step(__m128d &s, __m128d &c, __m128d &q, __m128d &d, __m128d &lo, __m128d &hi,
+                              __m128d va, bool axpy, const double *x, double *y) {
+    __m128d v = _mm_loadu_pd(y);
+    if (axpy) {
+        v = _mm_add_pd(v, _mm_mul_pd(va, _mm_loadu_pd(x)));
+        _mm_storeu_pd(y, v);
+    }
+    kbn_step(s, c, v);
+    if (STATS) {
+        kbn_step(q, d, _mm_mul_pd(v, v));
+        lo = _mm_min_pd(lo, v);
+        hi = _mm_max_pd(hi, v);
+    }
+}
+
+// 2 doubles per register, 4 registers per iteration as in kbn_sum_sse2
+template <bool STATS>
+static DaxpyReduction fused_sse2(int n, double a, const double *x, double *y) {
+    const bool axpy = a != 0.0;
+    const __m128d va = _mm_set1_pd(a);
+    __m128d s[4], c[4], q[4], d[4];
+    for (int k = 0; k < 4; k++) {
+        s[k] = c[k] = q[k] = d[k] = _mm_setzero_pd();
+    }
+    __m128d lo = _mm_set1_pd(INFINITY), hi = _mm_set1_pd(-INFINITY);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 4; k++) {
+            fused_step<STATS>(s[k], c[k], q[k], d[k], lo, hi, va, axpy, x + i + 2 * k, y + i + 2 * k);
+        }
+    }
+    for (; i + 2 <= n; i += 2) {
+        fused_step<STATS>(s[0], c[0], q[0], d[0], lo, hi, va, axpy, x + i, y + i);
+    }
+
+    // remainder, as in daxpy_sse2
+    if (axpy) {
+        for (int j = i; j < n; j++) {
+            y[j] += a * x[j];
+        }
+    }
+
+    // short vectors (small chunks) only touched the first register
+    const int regs = n >= 8 ? 4 : 1;
+    double sums[8], cs[8], sq_sums[8], sq_cs[8], mins[2], maxs[2];
+    for (int k = 0; k < regs; k++) {
+        _mm_storeu_pd(sums + 2 * k, s[k]);
+        _mm_storeu_pd(cs + 2 * k, c[k]);
+        _mm_storeu_pd(sq_sums + 2 * k, q[k]);
+        _mm_storeu_pd(sq_cs + 2 * k, d[k]);
+    }
+    _mm_storeu_pd(mins, lo);
+    _mm_storeu_pd(maxs, hi);
+
+    if (STATS) {
+        return daxpy_merge_lanes(sums, cs, sq_sums, sq_cs, 2 * regs, mins, maxs, 2, y + i, n - i);
+    }
+    DaxpyReduction r;
+    daxpy_reduction_clear(r);
+    r.sum = kbn_merge_lanes(sums, cs, 2 * regs, y + i, n - i);
+    return r;
+}
+
+CompensatedSum daxpy_sum_sse2(int n, double a, const double *x, double *y) {
+    return fused_sse2<false>(n, a, x, y).sum;
+}
+
+DaxpyReduction daxpy_reduce_sse2(int n, double a, const double *x, double *y) {
+    return fused_sse2<true>(n, a, x, y);
+}
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "daxpy.hpp"
+#include "daxpy_sum.hpp"
+#include "numa.hpp"
+#include "sum.hpp"
+#include "tuning.hpp"
+
+// below this, one chunk: nothing to gain, and timing is noise
+static const int TUNING_MIN_ELEMENTS = 1 << 12;
+// scratch vectors are capped at 2^24 elements (128 MiB each): longer
+// ones run from memory anyway, like the capped ones
+static const int TUNING_MAX_ELEMENTS = 1 << 24;
+static const int TUNING_REPEAT = 3;
+
+static size_t parse_size(const std::string &s) {
+    // "48K", "2048K", "32M"
+    size_t value = std::strtoull(s.c_str(), nullptr, 10);
+    switch (s.empty() ? ' ' : s.back()) {
+    case 'K':
+        return value << 10;
+    case 'M':
+        return value << 20;
+    case 'G':
+        return value << 30;
+    default:
+        return value;
+    }
+}
+
+static bool cache_sizes_sysfs(CacheSizes &sizes) {
+    bool found = false;
+    for (int index = 0; index < 16; index++) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_file(dir + "level"), type_file(dir + "type"), size_file(dir + "size");
+        int level;
+        std::string type, size;
+        if (!(level_file >> level) || !(type_file >> type) || !(size_file >> size)) {
+            break;
+        }
+        if (type == "Instruction") {
+            continue;
+        }
+        size_t bytes = parse_size(size);
+        if (level == 1) {
+            sizes.l1d = bytes;
+        } else if (level == 2) {
+            sizes.l2 = bytes;
+        } else if (level == 3) {
+            sizes.l3 = bytes;
+        }
+        found = true;
+    }
+    return found;
+}
+
+static bool cache_sizes_cpuid(CacheSizes &sizes) {
+#if defined(__x86_64__) || defined(__i386__)
+    // deterministic cache parameters, one subleaf per cache
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, nullptr) < 4) {
+        return false;
+    }
+    bool found = false;
+    for (unsigned int sub = 0; sub < 16; sub++) {
+        __cpuid_count(4, sub, eax, ebx, ecx, edx);
+        unsigned int type = eax & 0x1f; // 0 none, 1 data, 2 instruction, 3 unified
+        if (type == 0) {
+            break;
+        }
+        if (type == 2) {
+            continue;
+        }
+        unsigned int level = (eax >> 5) & 0x7;
+        size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+        size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+        size_t line = (ebx & 0xfff) + 1;
+        size_t sets = size_t(ecx) + 1;
+        size_t bytes = ways * partitions * line * sets;
+        if (level == 1) {
+            sizes.l1d = bytes;
+        } else if (level == 2) {
+            sizes.l2 = bytes;
+        } else if (level == 3) {
+            sizes.l3 = bytes;
+        }
+        found = true;
+    }
+    return found;
+#else
+    (void)sizes;
+    return false;
+#endif
+}
+
+const CacheSizes &cache_sizes() {
+    static const CacheSizes sizes = [] {
+        CacheSizes s = {0, 0, 0};
+        if (!cache_sizes_sysfs(s) && !cache_sizes_cpuid(s)) {
+            s = {32 << 10, 1 << 20, 8 << 20};
+        }
+        if (s.l1d == 0) {
+            s.l1d = 32 << 10;
+        }
+        return s;
+    }();
+    return sizes;
+}
+
+const char *chunked_kernel_name(ChunkedKernel kernel) {
+    switch (kernel) {
+    case ChunkedKernel::Sum:
+        return "sum";
+    case ChunkedKernel::DaxpySum:
+        return "daxpy_sum";
+    default:
+        return "daxpy";
+    }
+}
+
+static size_t bytes_per_element(ChunkedKernel kernel) {
+    // sum reads one vector, the daxpys read x and y
+    return kernel == ChunkedKernel::Sum ? sizeof(double) : 2 * sizeof(double);
+}
+
+std::vector<int> chunk_size_candidates(ChunkedKernel kernel, int n) {
+    const CacheSizes &c = cache_sizes();
+    const size_t bytes[] = {c.l1d / 2, c.l1d, c.l2 / 2, c.l2, c.l3 / 2};
+
+    std::vector<int> candidates;
+    for (size_t b: bytes) {
+        // whole cache lines of every vector, SIMD-friendly
+        size_t elements = b / bytes_per_element(kernel) / 64 * 64;
+        if (elements >= 64 && elements < size_t(n)) {
+            candidates.push_back(int(elements));
+        }
+    }
+    if (n > 0) {
+        candidates.push_back(n);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+static void run_chunked(ChunkedKernel kernel, bool parallel, int n, int chunk_size, const double *x, double *y) {
+    // the chunk loops of the 08 and 09 drivers: in parallel every thread
+    // walks its own numa_static_slice chunk by chunk, a shorter chunk
+    // last; a tiny a keeps y finite
+    const double a = 1e-20;
+    BinnedSum total;
+    binned_sum_clear(total);
+    CompensatedSum fused = {0.0, 0.0};
+
+    #pragma omp parallel if (parallel) reduction(binned_merge: total) reduction(compensated_merge: fused)
+    {
+        int thread = 0, threads = 1;
+#if defined(_OPENMP)
+        thread = omp_get_thread_num();
+        threads = omp_get_num_threads();
+#endif
+        size_t begin, end;
+        numa_static_slice(n, thread, threads, begin, end);
+        for (size_t start = begin; start < end; start += chunk_size) {
+            int count = std::min<size_t>(chunk_size, end - start);
+            switch (kernel) {
+            case ChunkedKernel::Daxpy:
+                daxpy(count, a, x + start, y + start);
+                break;
+            case ChunkedKernel::Sum:
+                binned_sum_add(total, y + start, count);
+                break;
+            case ChunkedKernel::DaxpySum:
+                fused = compensated_merge(fused, daxpy_sum_partial(count, a, x + start, y + start));
+                break;
+            }
+        }
+    }
+    volatile double sink = binned_sum_value(total) + fused.sum + fused.c;
+    (void)sink;
+}
+
+static int tune(ChunkedKernel kernel, int n, bool parallel) {
+    const int m = std::min(n, TUNING_MAX_ELEMENTS);
+    std::vector<double> x(m, 1.0), y(m, 0.5);
+
+    int best_chunk = n;
+    double best_time = INFINITY;
+    for (int chunk_size: chunk_size_candidates(kernel, n)) {
+        int probe_chunk = std::min(chunk_size, m);
+        run_chunked(kernel, parallel, m, probe_chunk, x.data(), y.data()); // warm up
+        for (int r = 0; r < TUNING_REPEAT; r++) {
+            auto start = std::chrono::steady_clock::now();
+            run_chunked(kernel, parallel, m, probe_chunk, x.data(), y.data());
+            auto end = std::chrono::steady_clock::now();
+            double t = std::chrono::duration<double>(end - start).count();
+            if (t < best_time) {
+                best_time = t;
+                best_chunk = chunk_size;
+            }
+        }
+    }
+    // 0: no chunking, whatever n in the size class
+    return best_chunk == n ? 0 : best_chunk;
+}
+
+static std::string tuning_cache_path() {
+    const char *path = std::getenv("SC4PS_TUNING_CACHE");
+    if (path != nullptr) {
+        return path;
+    }
+    const char *home = std::getenv("HOME");
+    if (home == nullptr) {
+        return "sc4ps_tuning.conf";
+    }
+    return std::string(home) + "/.cache/sc4ps_tuning.conf";
+}
+
+static std::string cache_signature() {
+    const CacheSizes &c = cache_sizes();
+    return std::to_string(c.l1d) + "," + std::to_string(c.l2) + "," + std::to_string(c.l3);
+}
+
+static std::map<std::string, int> load_tuning_cache(const std::string &path) {
+    // "key = value" lines; the whole file is dropped if it was tuned for
+    // other cache sizes
+    std::map<std::string, int> entries;
+    std::ifstream in(path);
+    std::string line;
+    bool valid = false;
+    while (std::getline(in, line)) {
+        size_t eq = line.find(" = ");
+        if (line.empty() || line[0] == '#' || eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq), value = line.substr(eq + 3);
+        if (key == "cache") {
+            valid = value == cache_signature();
+        } else {
+            entries[key] = std::atoi(value.c_str());
+        }
+    }
+    if (!valid) {
+        entries.clear();
+    }
+    return entries;
+}
+
+static void save_tuning_cache(const std::string &path, const std::map<std::string, int> &entries) {
+    // to a temporary file renamed over the old one, so that concurrent
+    // runs (MPI ranks) never read half a file
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        mkdir(path.substr(0, slash).c_str(), 0755); // ~/.cache may not exist yet
+    }
+    std::string tmp = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out) {
+            return;
+        }
+        out << "# chunk sizes tuned by sc4ps_kernels, safe to delete" << std::endl;
+        out << "cache = " << cache_signature() << std::endl;
+        for (const auto &entry: entries) {
+            out << entry.first << " = " << entry.second << std::endl;
+        }
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
+
+int tuned_chunk_size(ChunkedKernel kernel, int n, bool parallel) {
+    if (n < TUNING_MIN_ELEMENTS) {
+        return std::max(n, 1);
+    }
+
+    // size class: the power of two below n
+    int size_class = 0;
+    while ((n >> size_class) > 1) {
+        size_class++;
+    }
+    std::ostringstream key;
+    key << chunked_kernel_name(kernel) << (parallel ? ".omp" : "") << ".2^" << size_class;
+
+    static std::mutex mutex;
+    static std::map<std::string, int> tuned;
+    static std::string loaded_path;
+    static bool loaded = false;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // (re)loaded whenever SC4PS_TUNING_CACHE points somewhere else
+    const std::string path = tuning_cache_path();
+    if (!loaded || path != loaded_path) {
+        tuned = path.empty() ? std::map<std::string, int>() : load_tuning_cache(path);
+        loaded_path = path;
+        loaded = true;
+    }
+
+    auto it = tuned.find(key.str());
+    if (it == tuned.end()) {
+        it = tuned.emplace(key.str(), tune(kernel, n, parallel)).first;
+        if (!path.empty()) {
+            // merged with what other runs may have added meanwhile
+            std::map<std::string, int> entries = load_tuning_cache(path);
+            entries[key.str()] = it->second;
+            save_tuning_cache(path, entries);
+        }
+    }
+    // tuned for the size class, n may be below the chunk found
+    return it->second <= 0 ? n : std::min(it->second, n);
+}
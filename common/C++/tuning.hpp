@@ -0,0 +1,43 @@
+#ifndef TUNING_HPP
+#define TUNING_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Chunk sizes for the chunked kernels of tasks 08 and 09, tuned for the
+// host. The candidates are derived from the cache sizes: chunks whose
+// working set fills half of L1, L1, half of L2, L2 and half of L3, and
+// the whole vector. Each candidate is timed on scratch vectors and the
+// fastest wins.
+// Results are kept per kernel and per size class (the power of two
+// below n) in a small "key = value" file, so every size class is timed
+// only once per host. The file is $SC4PS_TUNING_CACHE, or
+// ~/.cache/sc4ps_tuning.conf. Set SC4PS_TUNING_CACHE to an empty
+// string to tune in every run without writing anything. A file written
+// on a host with other cache sizes is ignored.
+
+// Data cache sizes in bytes, 0 when there is no such level. Read from
+// sysfs, or CPUID leaf 4 when sysfs is not there; typical sizes when
+// neither is available.
+struct CacheSizes {
+    size_t l1d;
+    size_t l2;
+    size_t l3;
+};
+
+const CacheSizes &cache_sizes();
+
+enum class ChunkedKernel { Daxpy = 0, Sum, DaxpySum };
+
+const char *chunked_kernel_name(ChunkedKernel kernel);
+
+// The chunk sizes worth trying for n elements, in increasing order;
+// the last one is n itself
+std::vector<int> chunk_size_candidates(ChunkedKernel kernel, int n);
+
+// The best chunk size for n elements (in [1, n], n for short vectors),
+// from the tuning cache or timed on first use. parallel is for the
+// OpenMP versions, whose chunks are shared between the threads.
+int tuned_chunk_size(ChunkedKernel kernel, int n, bool parallel = false);
+
+#endif // TUNING_HPP
@@ -0,0 +1,391 @@
+#ifndef VECTOR_HPP
+#define VECTOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "sum.hpp"
+
+// Level-1 BLAS with expression templates. An expression such as
+//     a*x + b*y - z
+// is not computed when written: it is a small object holding references
+// to x, y, z and the scalars, whose operator[] computes one element.
+// Assigning it to a Vector, or reducing it with sum, dot or a norm, runs
+// a single loop over all the operands, with no temporary vector; the
+// loop is vectorized by the compiler and, built with OpenMP, split
+// between the threads when the vectors are long enough. Hence
+//     d = a*x + b*y - z;
+//     s = dot(d, w);
+// sweeps memory twice, and
+//     s = assign_and_dot(d, a*x + b*y - z, w);
+// only once. Build the caller with optimization on, the expressions
+// rely on inlining.
+// The reductions evaluate the expression block by block into a buffer
+// that stays in L1 cache and sum it with the SIMD KBN kernel (sum.hpp):
+// they are compensated, in double precision whatever the element type.
+
+// elements per block of the reductions, 8 KiB of doubles
+const size_t VECTOR_BLOCK = 1024;
+// shorter vectors are not worth waking the OpenMP threads up for
+const size_t VECTOR_PARALLEL_MIN = 1 << 15;
+
+// Base of all expressions (CRTP): E has size() and operator[](i)
+template <typename E>
+struct VectorExpr {
+    const E &derived() const { return static_cast<const E &>(*this); }
+    size_t size() const { return derived().size(); }
+    auto operator[](size_t i) const { return derived()[i]; }
+};
+
+// Owning vector, 64-byte aligned. Move-only like Matrix: a new copy has
+// to be explicit (copy()); assigning a vector or an expression to an
+// existing vector writes into its storage, whose size must match.
+template <typename T>
+class Vector : public VectorExpr<Vector<T>> {
+public:
+    static const size_t ALIGNMENT = 64;
+    typedef T value_type;
+
+    Vector() : data_(nullptr), size_(0) {}
+
+    explicit Vector(size_t n, T init_value = T()) : size_(n) {
+        void *p = nullptr;
+        if (posix_memalign(&p, ALIGNMENT, std::max<size_t>(1, n) * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<T *>(p);
+        std::fill(data_, data_ + n, init_value);
+    }
+
+    // evaluates e into a new vector
+    template <typename E>
+    Vector(const VectorExpr<E> &e) : Vector(e.size()) {
+        assign(e);
+    }
+
+    Vector(const Vector &) = delete;
+
+    Vector(Vector &&other) noexcept : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    Vector &operator=(Vector &&other) noexcept {
+        if (this != &other) {
+            free(data_);
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    Vector &operator=(const Vector &other) {
+        return assign(other);
+    }
+
+    template <typename E>
+    Vector &operator=(const VectorExpr<E> &e) {
+        return assign(e);
+    }
+
+    // in place, element by element, e.g. y += a*x is a daxpy
+    template <typename E>
+    Vector &operator+=(const VectorExpr<E> &e);
+    template <typename E>
+    Vector &operator-=(const VectorExpr<E> &e);
+    Vector &operator*=(T alpha);
+
+    ~Vector() { free(data_); }
+
+    Vector copy() const {
+        Vector v(size_);
+        std::copy(data_, data_ + size_, v.data_);
+        return v;
+    }
+
+    T &operator[](size_t i) { return data_[i]; }
+    const T &operator[](size_t i) const { return data_[i]; }
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    template <typename E>
+    Vector &assign(const VectorExpr<E> &e);
+
+    T *data_;
+    size_t size_;
+};
+
+// Expressions keep vectors by reference and other expressions, small
+// temporaries, by value
+template <typename E>
+struct VectorOperand {
+    typedef const E type;
+};
+
+template <typename T>
+struct VectorOperand<Vector<T>> {
+    typedef const Vector<T> &type;
+};
+
+inline void vector_check_sizes(size_t a, size_t b) {
+    if (a != b) {
+        throw std::invalid_argument("vector sizes differ");
+    }
+}
+
+// Element-wise binary expression, Op being one of the structs below
+template <typename L, typename R, typename Op>
+class VectorBinary : public VectorExpr<VectorBinary<L, R, Op>> {
+public:
+    VectorBinary(const L &l, const R &r) : l_(l), r_(r) {
+        vector_check_sizes(l.size(), r.size());
+    }
+    size_t size() const { return l_.size(); }
+    auto operator[](size_t i) const { return Op::apply(l_[i], r_[i]); }
+
+private:
+    typename VectorOperand<L>::type l_;
+    typename VectorOperand<R>::type r_;
+};
+
+struct VectorAdd {
+    template <typename A, typename B>
+    static auto apply(A a, B b) { return a + b; }
+};
+
+struct VectorSubtract {
+    template <typename A, typename B>
+    static auto apply(A a, B b) { return a - b; }
+};
+
+struct VectorMultiply {
+    template <typename A, typename B>
+    static auto apply(A a, B b) { return a * b; }
+};
+
+// for dot products, exact for float operands
+struct VectorMultiplyDouble {
+    template <typename A, typename B>
+    static double apply(A a, B b) { return (double)a * (double)b; }
+};
+
+// alpha * e
+template <typename E>
+class VectorScaled : public VectorExpr<VectorScaled<E>> {
+public:
+    typedef typename std::decay<decltype(std::declval<const E &>()[0])>::type value_type;
+
+    VectorScaled(value_type alpha, const E &e) : alpha_(alpha), e_(e) {}
+    size_t size() const { return e_.size(); }
+    auto operator[](size_t i) const { return alpha_ * e_[i]; }
+
+private:
+    value_type alpha_;
+    typename VectorOperand<E>::type e_;
+};
+
+template <typename L, typename R>
+VectorBinary<L, R, VectorAdd> operator+(const VectorExpr<L> &l, const VectorExpr<R> &r) {
+    return VectorBinary<L, R, VectorAdd>(l.derived(), r.derived());
+}
+
+template <typename L, typename R>
+VectorBinary<L, R, VectorSubtract> operator-(const VectorExpr<L> &l, const VectorExpr<R> &r) {
+    return VectorBinary<L, R, VectorSubtract>(l.derived(), r.derived());
+}
+
+template <typename E>
+VectorScaled<E> operator*(typename VectorScaled<E>::value_type alpha, const VectorExpr<E> &e) {
+    return VectorScaled<E>(alpha, e.derived());
+}
+
+template <typename E>
+VectorScaled<E> operator*(const VectorExpr<E> &e, typename VectorScaled<E>::value_type alpha) {
+    return VectorScaled<E>(alpha, e.derived());
+}
+
+template <typename E>
+VectorScaled<E> operator-(const VectorExpr<E> &e) {
+    return VectorScaled<E>(-1, e.derived());
+}
+
+// Element-wise (Hadamard) product
+template <typename L, typename R>
+VectorBinary<L, R, VectorMultiply> hadamard(const VectorExpr<L> &l, const VectorExpr<R> &r) {
+    return VectorBinary<L, R, VectorMultiply>(l.derived(), r.derived());
+}
+
+// Runs f(start, len) on every block of [0, n), split between the OpenMP
+// threads for long vectors. Short ones stay on the calling thread: even
+// a parallel region with a false if clause costs about a microsecond.
+template <typename F>
+void vector_for_blocks(size_t n, F f) {
+    const size_t blocks = (n + VECTOR_BLOCK - 1) / VECTOR_BLOCK;
+    if (n < VECTOR_PARALLEL_MIN) {
+        for (size_t b = 0; b < blocks; b++) {
+            f(b * VECTOR_BLOCK, std::min(VECTOR_BLOCK, n - b * VECTOR_BLOCK));
+        }
+        return;
+    }
+    #pragma omp parallel for schedule(static)
+    for (size_t b = 0; b < blocks; b++) {
+        f(b * VECTOR_BLOCK, std::min(VECTOR_BLOCK, n - b * VECTOR_BLOCK));
+    }
+}
+
+// Same, merging the compensated sums f(start, len) of the blocks. The
+// order in which OpenMP merges the partial sums of the threads is
+// unspecified, so the last bit can change with the number of threads.
+template <typename F>
+CompensatedSum vector_sum_blocks(size_t n, F f) {
+    const size_t blocks = (n + VECTOR_BLOCK - 1) / VECTOR_BLOCK;
+    CompensatedSum total = {0.0, 0.0};
+    if (n < VECTOR_PARALLEL_MIN) {
+        for (size_t b = 0; b < blocks; b++) {
+            total = compensated_merge(total, f(b * VECTOR_BLOCK, std::min(VECTOR_BLOCK, n - b * VECTOR_BLOCK)));
+        }
+        return total;
+    }
+    #pragma omp parallel for schedule(static) reduction(compensated_merge: total)
+    for (size_t b = 0; b < blocks; b++) {
+        total = compensated_merge(total, f(b * VECTOR_BLOCK, std::min(VECTOR_BLOCK, n - b * VECTOR_BLOCK)));
+    }
+    return total;
+}
+
+template <typename T>
+template <typename E>
+Vector<T> &Vector<T>::assign(const VectorExpr<E> &expr) {
+    const E &e = expr.derived();
+    vector_check_sizes(size_, e.size());
+    T *out = data_;
+
+    // every element only depends on the operands at the same index, so
+    // out may be one of them (y = a*x + y)
+    vector_for_blocks(size_, [&](size_t start, size_t len) {
+        #pragma omp simd
+        for (size_t i = start; i < start + len; i++) {
+            out[i] = e[i];
+        }
+    });
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+Vector<T> &Vector<T>::operator+=(const VectorExpr<E> &e) {
+    return assign(*this + e);
+}
+
+template <typename T>
+template <typename E>
+Vector<T> &Vector<T>::operator-=(const VectorExpr<E> &e) {
+    return assign(*this - e);
+}
+
+template <typename T>
+Vector<T> &Vector<T>::operator*=(T alpha) {
+    return assign(alpha * *this);
+}
+
+// Compensated sum of the elements of e
+template <typename E>
+CompensatedSum vector_sum_partial(const VectorExpr<E> &expr) {
+    const E &e = expr.derived();
+    return vector_sum_blocks(e.size(), [&](size_t start, size_t len) {
+        double block[VECTOR_BLOCK];
+        #pragma omp simd
+        for (size_t i = 0; i < len; i++) {
+            block[i] = e[start + i];
+        }
+        return KahanBabushkaNeumaierSum_partial(block, len);
+    });
+}
+
+template <typename E>
+double sum(const VectorExpr<E> &e) {
+    CompensatedSum s = vector_sum_partial(e);
+    return s.sum + s.c;
+}
+
+template <typename L, typename R>
+double dot(const VectorExpr<L> &l, const VectorExpr<R> &r) {
+    return sum(VectorBinary<L, R, VectorMultiplyDouble>(l.derived(), r.derived()));
+}
+
+// Euclidean norm. The squares are summed without scaling: elements
+// beyond about 1e154 in magnitude overflow.
+template <typename E>
+double norm2(const VectorExpr<E> &e) {
+    return std::sqrt(dot(e, e));
+}
+
+// |e|, in double
+template <typename E>
+class VectorAbs : public VectorExpr<VectorAbs<E>> {
+public:
+    explicit VectorAbs(const E &e) : e_(e) {}
+    size_t size() const { return e_.size(); }
+    double operator[](size_t i) const { return std::fabs((double)e_[i]); }
+
+private:
+    typename VectorOperand<E>::type e_;
+};
+
+template <typename E>
+double norm1(const VectorExpr<E> &e) {
+    return sum(VectorAbs<E>(e.derived()));
+}
+
+template <typename E>
+double norm_inf(const VectorExpr<E> &expr) {
+    const E &e = expr.derived();
+    const size_t n = e.size();
+    double m = 0.0;
+    if (n < VECTOR_PARALLEL_MIN) {
+        #pragma omp simd reduction(max: m)
+        for (size_t i = 0; i < n; i++) {
+            m = std::max(m, std::fabs((double)e[i]));
+        }
+        return m;
+    }
+    #pragma omp parallel for simd schedule(static) reduction(max: m)
+    for (size_t i = 0; i < n; i++) {
+        m = std::max(m, std::fabs((double)e[i]));
+    }
+    return m;
+}
+
+// d = e and dot(d, w) in the same sweep: each block of d is written and
+// multiplied by w while in cache
+template <typename T, typename E, typename W>
+double assign_and_dot(Vector<T> &d, const VectorExpr<E> &expr, const VectorExpr<W> &weights) {
+    const E &e = expr.derived();
+    const W &w = weights.derived();
+    vector_check_sizes(d.size(), e.size());
+    vector_check_sizes(d.size(), w.size());
+    T *out = d.data();
+
+    CompensatedSum s = vector_sum_blocks(d.size(), [&](size_t start, size_t len) {
+        double block[VECTOR_BLOCK];
+        #pragma omp simd
+        for (size_t i = start; i < start + len; i++) {
+            out[i] = e[i];
+            block[i - start] = (double)out[i] * (double)w[i];
+        }
+        return KahanBabushkaNeumaierSum_partial(block, len);
+    });
+    return s.sum + s.c;
+}
+
+#endif // VECTOR_HPP
@@ -0,0 +1,263 @@
+#include <cstring>
+
+#include "async_io.hpp"
+#include "vector_io.hpp"
+
+VectorFileHeader make_vector_header(uint64_t N, const double *vect) {
+    VectorFileHeader header = {};
+    std::memcpy(header.magic, VECTOR_FILE_MAGIC, sizeof(header.magic));
+    header.version = VECTOR_FILE_VERSION;
+    header.dtype = DTYPE_FLOAT64;
+    header.length = N;
+    header.payload_offset = VECTOR_FILE_ALIGNMENT;
+    if (vect != nullptr) {
+        header.checksum_type = CHECKSUM_CRC32C;
+        header.checksum = crc32c(0, vect, N * sizeof(double));
+    }
+    return header;
+}
+
+std::vector<char> vector_header_block(const VectorFileHeader &header) {
+    std::vector<char> block(header.payload_offset, 0);
+    std::memcpy(block.data(), &header, sizeof(header));
+    return block;
+}
+
+VectorFileHeader read_vector_header(const std::string &fname) {
+    std::ifstream file(fname, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Error: cannot open file <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+    uint64_t file_size = file.tellg();
+    file.seekg(0);
+
+    VectorFileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, VECTOR_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: <" << fname << "> is not a vector file (bad magic)\n";
+        std::exit(EXIT_FAILURE);
+    }
+    if (header.version != VECTOR_FILE_VERSION || header.dtype != DTYPE_FLOAT64) {
+        std::cerr << "Error: <" << fname << "> has unsupported version " << header.version
+                  << " or dtype " << header.dtype << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+    if (header.payload_offset < sizeof(header) || file_size < header.payload_offset
+        || (file_size - header.payload_offset) / sizeof(double) < header.length) {
+        std::cerr << "Error: <" << fname << "> is truncated, expected " << header.length << " doubles\n";
+        std::exit(EXIT_FAILURE);
+    }
+    return header;
+}
+
+void check_vector_length(const std::string &fname, const VectorFileHeader &header, uint64_t N) {
+    if (header.length != N) {
+        std::cerr << "Error: <" << fname << "> holds " << header.length << " doubles, expected " << N << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void verify_vector_checksum(const std::string &fname, const VectorFileHeader &header, const double *vect) {
+    if (header.checksum_type == CHECKSUM_NONE)
+        return;
+    if (crc32c(0, vect, header.length * sizeof(double)) != header.checksum) {
+        std::cerr << "Error: checksum mismatch in <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void read_vector_binary(int N, const std::string &fname, double * &vector, bool verify) {
+    VectorFileHeader header = read_vector_header(fname);
+    check_vector_length(fname, header, N);
+
+    std::ifstream file(fname, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: cannot open file <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+    file.seekg(header.payload_offset);
+
+    if (vector == nullptr) {
+        vector = new double[N];
+        if (vector == nullptr) {
+            std::cerr << "Memory allocation failed\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    file.read(reinterpret_cast<char*>(vector), N * sizeof(double));
+    if (!file) {
+        std::cerr << "Error: failed to read data from file <" << fname << ">\n";
+        delete[] vector;
+        std::exit(EXIT_FAILURE);
+    }
+    if (verify)
+        verify_vector_checksum(fname, header, vector);
+}
+
+void dump_vector_binary(int N, const std::string &fname, double *vect) {
+    std::ofstream file(fname, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: cannot open file <" << fname << ">\n";
+        delete[] vect;
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Writing file <" << fname << "> ...";
+    std::vector<char> header = vector_header_block(make_vector_header(N, vect));
+    file.write(header.data(), header.size());
+    file.write(reinterpret_cast<const char*>(vect), N * sizeof(double));
+    if (!file) {
+        std::cerr << "Error: failed to write data to file <" << fname << ">\n";
+        delete[] vect;
+        std::exit(EXIT_FAILURE);
+    }
+    std::cout << " done.\n";
+}
+
+// Tags of the AsyncIO requests: file * segments + segment for the reads
+static const uint64_t WRITE_TAG = uint64_t(1) << 63;
+
+AsyncVectorIO::AsyncVectorIO(size_t N, size_t segment, unsigned depth, bool use_uring)
+    : n(N), segment(std::max<size_t>(segment, 1)), segments((N + this->segment - 1) / this->segment),
+      io(new AsyncIO(depth, use_uring)), arrived(segments, 0) {
+}
+
+AsyncVectorIO::~AsyncVectorIO() {
+    // Let the requests still queued finish before their files are closed
+    io.reset();
+    for (const std::vector<File> *files: {&reads, &dumps}) {
+        for (const File &f: *files) {
+            if (f.fd >= 0)
+                close(f.fd);
+        }
+    }
+}
+
+const char *AsyncVectorIO::backend() const {
+    return io->backend();
+}
+
+void AsyncVectorIO::read(const std::string &fname, double *vect, bool verify) {
+    if (started) {
+        std::cerr << "Error: <" << fname << "> added for reading after the first segment\n";
+        std::exit(EXIT_FAILURE);
+    }
+    VectorFileHeader header = read_vector_header(fname);
+    check_vector_length(fname, header, n);
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: cannot open file <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+    reads.push_back({fname, fd, header, verify, vect, 0, 0});
+}
+
+int AsyncVectorIO::dump(const std::string &fname) {
+    int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: cannot open file <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+    dumps.push_back({fname, fd, make_vector_header(n, nullptr), false, nullptr, 0, 0});
+    return dumps.size() - 1;
+}
+
+void AsyncVectorIO::complete(uint64_t tag) {
+    if (tag & WRITE_TAG)
+        writing--;
+    else
+        arrived[tag % segments]++;
+}
+
+bool AsyncVectorIO::wait_segment(size_t &offset, size_t &count) {
+    if (!started) {
+        started = true;
+        for (size_t s = 0; s < segments; s++) {
+            size_t bytes = std::min(segment, n - s * segment) * sizeof(double);
+            for (size_t file = 0; file < reads.size(); file++) {
+                const File &f = reads[file];
+                io->submit_read(f.fd, f.data + s * segment, bytes,
+                                f.header.payload_offset + s * segment * sizeof(double), file * segments + s);
+            }
+        }
+    }
+    if (next == segments)
+        return false;
+
+    while (arrived[next] < reads.size())
+        complete(io->wait());
+    offset = next * segment;
+    count = std::min(segment, n - offset);
+    for (File &f: reads) {
+        if (f.verify)
+            f.crc = crc32c(f.crc, f.data + offset, count * sizeof(double));
+    }
+    next++;
+    return true;
+}
+
+void AsyncVectorIO::dump_segment(int file, size_t offset, size_t count, const double *vect) {
+    File &f = dumps[file];
+    if (offset != f.dumped || count > n - offset) {
+        std::cerr << "Error: elements [" << offset << ", " << offset + count << ") of <" << f.fname
+                  << "> dumped out of order\n";
+        std::exit(EXIT_FAILURE);
+    }
+    size_t bytes = count * sizeof(double);
+    f.crc = crc32c(f.crc, vect + offset, bytes);
+    io->submit_write(f.fd, vect + offset, bytes, f.header.payload_offset + offset * sizeof(double), WRITE_TAG | file);
+    f.dumped += count;
+    writing++;
+}
+
+void AsyncVectorIO::finish() {
+    // The segments nobody asked for still have to arrive (and be checksummed)
+    size_t offset, count;
+    while (wait_segment(offset, count)) {
+    }
+    while (writing > 0)
+        complete(io->wait());
+
+    for (File &f: dumps) {
+        if (f.dumped != n) {
+            std::cerr << "Error: " << f.dumped << " of the " << n << " doubles of <" << f.fname << "> dumped\n";
+            std::exit(EXIT_FAILURE);
+        }
+        f.header.checksum_type = CHECKSUM_CRC32C;
+        f.header.checksum = f.crc;
+        std::vector<char> block = vector_header_block(f.header);
+        if (pwrite(f.fd, block.data(), block.size(), 0) != ssize_t(block.size())) {
+            std::cerr << "Error: failed to write data to file <" << f.fname << ">\n";
+            std::exit(EXIT_FAILURE);
+        }
+        close(f.fd);
+        f.fd = -1;
+    }
+    for (File &f: reads) {
+        close(f.fd);
+        f.fd = -1;
+        if (f.verify && f.header.checksum_type != CHECKSUM_NONE && f.crc != f.header.checksum) {
+            std::cerr << "Error: checksum mismatch in <" << f.fname << ">\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void read_vector_binary_async(size_t N, const std::string &fname, double *vect, bool verify) {
+    AsyncVectorIO io(N);
+    io.read(fname, vect, verify);
+    io.finish();
+}
+
+void dump_vector_binary_async(size_t N, const std::string &fname, const double *vect) {
+    std::cout << "Writing file <" << fname << "> ...";
+    AsyncVectorIO io(N);
+    int file = io.dump(fname);
+    size_t offset, count;
+    while (io.wait_segment(offset, count))
+        io.dump_segment(file, offset, count, vect);
+    io.finish();
+    std::cout << " done.\n";
+}
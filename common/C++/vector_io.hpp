@@ -0,0 +1,253 @@
+#ifndef VECTOR_IO_HPP
+#define VECTOR_IO_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "crc32c.hpp"
+
+/*
+Self-describing binary vector files
+[ VectorFileHeader | zero padding | payload: length doubles ]
+The payload starts at payload_offset, VECTOR_FILE_ALIGNMENT for the
+files written here, so it is page aligned for mmap and suitably aligned
+for O_DIRECT. Fields are stored in host byte order (little endian on
+every machine we run on). The checksum, when present, is the CRC-32C of
+the payload bytes.
+*/
+const char VECTOR_FILE_MAGIC[8] = {'S', 'C', '4', 'P', 'S', 'V', 'E', 'C'};
+const uint32_t VECTOR_FILE_VERSION = 1;
+const uint64_t VECTOR_FILE_ALIGNMENT = 4096;
+
+enum VectorDtype : uint32_t { DTYPE_FLOAT64 = 1 };
+enum VectorChecksum : uint32_t { CHECKSUM_NONE = 0, CHECKSUM_CRC32C = 1 };
+
+struct VectorFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t length;         // number of elements
+    uint64_t payload_offset; // in bytes, from the start of the file
+    uint32_t checksum_type;
+    uint32_t checksum;
+};
+
+// With vect == nullptr the checksum is left out
+VectorFileHeader make_vector_header(uint64_t N, const double *vect);
+// What goes in front of the payload: the header, zero padded
+std::vector<char> vector_header_block(const VectorFileHeader &header);
+
+// The functions below print an error and exit on any failure
+VectorFileHeader read_vector_header(const std::string &fname);
+void check_vector_length(const std::string &fname, const VectorFileHeader &header, uint64_t N);
+// Nothing to check for files written without a checksum
+void verify_vector_checksum(const std::string &fname, const VectorFileHeader &header, const double *vect);
+
+// Reads the N doubles of fname into vector, allocated with new[] if
+// nullptr
+void read_vector_binary(int N, const std::string &fname, double * &vector, bool verify = false);
+// Writes vect with its checksum; on failure vect, allocated with new[],
+// is released before exiting
+void dump_vector_binary(int N, const std::string &fname, double *vect);
+
+class AsyncIO;
+
+class AsyncVectorIO {
+    /*
+    Segmented asynchronous reads and writes of vector files of N doubles
+    The payloads are cut into segments of `segment` elements and every
+    transfer goes through one AsyncIO queue (io_uring, or a thread pool
+    without it), so the reads of several files and the writes of the
+    results are in flight together. The first wait_segment() queues the
+    reads of every file added by read(), segment by segment across the
+    files (x0, y0, x1, y1, ...), and hands the segments out in order as
+    soon as they have arrived in all of them, so the caller can compute
+    one while the next are still coming in and queue its result with
+    dump_segment(). Checksums are accumulated segment by segment:
+    finish() waits for the writes, gives the dumped files their header
+    and verifies the files read with verify set.
+    The buffers must stay alive until finish().
+    */
+public:
+    AsyncVectorIO(size_t N, size_t segment = 1 << 20, unsigned depth = 8, bool use_uring = true);
+    ~AsyncVectorIO();
+
+    AsyncVectorIO(const AsyncVectorIO &) = delete;
+    AsyncVectorIO &operator=(const AsyncVectorIO &) = delete;
+
+    // "io_uring" or "thread pool"
+    const char *backend() const;
+
+    // The payload of fname is to be read into vect[0, N); call before the
+    // first wait_segment
+    void read(const std::string &fname, double *vect, bool verify = false);
+    // Creates fname, returns the file to pass to dump_segment
+    int dump(const std::string &fname);
+    // Next segment [offset, offset + count) that has arrived in every file
+    // read, in order; false once they have all been handed out
+    bool wait_segment(size_t &offset, size_t &count);
+    // Queues the write of vect[offset, offset + count); the ranges of a
+    // file are dumped in order and without gaps
+    void dump_segment(int file, size_t offset, size_t count, const double *vect);
+    // Waits for everything, then writes the headers and checks the
+    // checksums; exits on a mismatch like the other functions here
+    void finish();
+
+private:
+    struct File {
+        std::string fname;
+        int fd;
+        VectorFileHeader header;
+        bool verify;
+        double *data;       // where a read file goes
+        uint32_t crc;
+        size_t dumped;      // elements queued for writing
+    };
+
+    void complete(uint64_t tag);
+
+    size_t n, segment, segments;
+    std::unique_ptr<AsyncIO> io;
+    std::vector<File> reads, dumps;
+    std::vector<size_t> arrived; // reads completed, per segment
+    bool started = false;        // reads queued
+    size_t next = 0;             // next segment for wait_segment
+    size_t writing = 0;          // writes in flight
+};
+
+// read_vector_binary / dump_vector_binary through AsyncVectorIO, with
+// the segments transferred concurrently
+void read_vector_binary_async(size_t N, const std::string &fname, double *vect, bool verify = false);
+void dump_vector_binary_async(size_t N, const std::string &fname, const double *vect);
+
+template <typename Fill>
+void dump_vector_binary_streaming(size_t N, const std::string &fname, Fill fill, size_t block_size = 1 << 17) {
+    /*
+    Write a vector file without materializing the vector
+    fill(offset, count, buffer) has to produce elements [offset, offset
+    + count) into buffer. Blocks of block_size elements are filled into
+    one of two buffers while the other is written (and checksummed) by a
+    second thread, so filling and writing overlap and memory stays at two
+    blocks whatever N is. The header is rewritten with the checksum once
+    the payload is complete.
+    */
+    std::ofstream file(fname, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: cannot open file <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+    VectorFileHeader header = make_vector_header(N, nullptr);
+    std::vector<char> block = vector_header_block(header);
+    file.write(block.data(), block.size());
+
+    uint32_t crc = 0;
+    auto write_block = [&file, &crc](const double *buffer, size_t count) {
+        file.write(reinterpret_cast<const char*>(buffer), count * sizeof(double));
+        crc = crc32c(crc, buffer, count * sizeof(double));
+    };
+
+    std::vector<double> buffers[2];
+    buffers[0].resize(std::min(block_size, N));
+    buffers[1].resize(std::min(block_size, N));
+    std::future<void> writing;
+    int cur = 0;
+    for (size_t offset = 0; offset < N; offset += block_size, cur = 1 - cur) {
+        size_t count = std::min(block_size, N - offset);
+        fill(offset, count, buffers[cur].data());
+        // the previous block must be out before its buffer gets refilled
+        if (writing.valid())
+            writing.get();
+        writing = std::async(std::launch::async, write_block, buffers[cur].data(), count);
+    }
+    if (writing.valid())
+        writing.get();
+
+    header.checksum_type = CHECKSUM_CRC32C;
+    header.checksum = crc;
+    block = vector_header_block(header);
+    file.seekp(0);
+    file.write(block.data(), block.size());
+    if (!file) {
+        std::cerr << "Error: failed to write data to file <" << fname << ">\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+class MappedVector {
+    /*
+    Read-only, memory-mapped view of a binary vector file
+    The N doubles are used in place from the page cache: nothing is
+    allocated or copied, and concurrent runs reading the same file share
+    the same physical pages. The mapping is advised for a sequential
+    scan (aggressive readahead) and, where the kernel supports it for
+    file mappings, for transparent huge pages. The whole file is mapped,
+    the header included, and data() points at the payload.
+    */
+public:
+    MappedVector(size_t N, const std::string &fname, bool verify = false) : n(N) {
+        VectorFileHeader header = read_vector_header(fname);
+        check_vector_length(fname, header, N);
+        offset = header.payload_offset;
+
+        int fd = open(fname.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: cannot open file <" << fname << ">\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        {
+            void *addr = mmap(nullptr, bytes(), PROT_READ, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                std::cerr << "Error: cannot map file <" << fname << ">\n";
+                close(fd);
+                std::exit(EXIT_FAILURE);
+            }
+            base = addr;
+            vector = reinterpret_cast<const double*>(static_cast<const char*>(addr) + offset);
+
+            // Hints only, a kernel that does not know them just ignores them
+            madvise(addr, bytes(), MADV_SEQUENTIAL);
+            madvise(addr, bytes(), MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+            madvise(addr, bytes(), MADV_HUGEPAGE);
+#endif
+        }
+        // The mapping keeps its own reference to the file
+        close(fd);
+
+        if (verify)
+            verify_vector_checksum(fname, header, vector);
+    }
+
+    ~MappedVector() {
+        munmap(base, bytes());
+    }
+
+    MappedVector(const MappedVector &) = delete;
+    MappedVector &operator=(const MappedVector &) = delete;
+
+    const double *data() const { return vector; }
+    size_t size() const { return n; }
+    const double &operator[](size_t i) const { return vector[i]; }
+
+private:
+    size_t bytes() const { return offset + n * sizeof(double); }
+
+    size_t n;
+    size_t offset;
+    void *base = nullptr;
+    const double *vector = nullptr;
+};
+
+#endif // VECTOR_IO_HPP